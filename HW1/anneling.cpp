@@ -5,6 +5,9 @@
 #include<vector>
 #include<climits>
 #include"ga_util.h"
+#include"expr_vm.h"
+#include"anytime.h"
+#include"low_discrepancy.h"
 using namespace std;
 
 struct cell{
@@ -20,6 +23,11 @@ public:
     cell cur_node, best_node;   // 目前的 node, 記錄下分數最好的 node
     vector<cell> best_node_list;    // 記錄每一個 iteration 裡面最佳的 cell.
     vector<cell> next_nodes;
+    ExprVM *fitness_expr = NULL;    // 不為 NULL 時以運算式取代內建的 fitness.
+    AnytimeTrace *trace = NULL;     // 不為 NULL 時記錄每次 evaluation 後的 best-so-far.
+    Sampler *init_sampler = NULL;   // 不為 NULL 時 initialize() 取序列的下一個點, 多次 run() 的起點均勻分布.
+    Sampler *move_sampler = NULL;   // 不為 NULL 時 move() 的鄰居是一組新的 scrambled 點集.
+    double sample[60];              // move_sampler 的 30 個點, x1 之後是 x2.
     Anneling(int max_iter, float min_bound, float max_bound, float precision, float temperature);
     void initialize();
     void evaluate(cell &node);
@@ -44,17 +52,31 @@ double Anneling::randfloat(float min, float max){
 }
 
 void Anneling::initialize(){
-    cur_node.x1 = randfloat(min_bound, max_bound);
-    cur_node.x2 = randfloat(min_bound, max_bound);
+    if(init_sampler != NULL){
+        double u[2];
+        init_sampler->next(1, u, min_bound, max_bound);
+        cur_node.x1 = u[0];
+        cur_node.x2 = u[1];
+    }
+    else{
+        cur_node.x1 = randfloat(min_bound, max_bound);
+        cur_node.x2 = randfloat(min_bound, max_bound);
+    }
     check_bound(cur_node);
 }
 
 void Anneling::evaluate(cell &node){
-    double x1 = node.x1, x2 = node.x2;
-    double left_part = pow(x1 * x1 + x2 * x2, 0.25),
-            right_part = pow(sin(50 * pow((x1 * x1 + x2 * x2), 0.1)), 2.0) + 1;
+    if(fitness_expr != NULL)
+        node.fitness = fitness_expr->eval(node.x1, node.x2);
+    else{
+        double x1 = node.x1, x2 = node.x2;
+        double left_part = pow(x1 * x1 + x2 * x2, 0.25),
+                right_part = pow(sin(50 * pow((x1 * x1 + x2 * x2), 0.1)), 2.0) + 1;
 
-    node.fitness = left_part * right_part;
+        node.fitness = left_part * right_part;
+    }
+    if(trace != NULL)
+        trace->record(node.fitness);
 }
 void Anneling::check_bound(cell &node){
     if(node.x1 < min_bound) node.x1 = min_bound;
@@ -65,10 +87,20 @@ void Anneling::check_bound(cell &node){
 
 void Anneling::move(){
     next_nodes.clear();
+    if(move_sampler != NULL){
+        move_sampler->restart();
+        move_sampler->next(30, sample, -1*precision, precision);
+    }
     for(int i=0;i<30;i++){
         cell node;
-        node.x1 = cur_node.x1 + randfloat(-1*precision, precision);
-        node.x2 = cur_node.x2 + randfloat(-1*precision, precision);
+        if(move_sampler != NULL){
+            node.x1 = cur_node.x1 + sample[i];
+            node.x2 = cur_node.x2 + sample[30 + i];
+        }
+        else{
+            node.x1 = cur_node.x1 + randfloat(-1*precision, precision);
+            node.x2 = cur_node.x2 + randfloat(-1*precision, precision);
+        }
         check_bound(node);
         evaluate(node);
         next_nodes.push_back(node);
@@ -138,16 +170,42 @@ cell Anneling::run(string mode){
     return best_node;
 }
 
-int main(){
+#ifndef GA_NO_MAIN    // pyga.cpp 等其他程式 include 這個檔案時不需要 main.
+// ./anneling.out [--sampler sobol|halton|lhs] [--move-sampler sobol|halton|lhs]
+//        ["fitness expression" [min_bound max_bound]]
+// --sampler: 每次 run() 的起點依序取自同一個序列; --move-sampler: move() 的 30 個鄰居.
+int main(int argc, char *argv[]){
     srand((unsigned)time(NULL));  // (unsigned)time(NULL) 1617968974
-    int max_iter=1000, min_bound=0, max_bound=1;
+    int max_iter=1000;
+    float min_bound=0, max_bound=1;
     float precision=0.01;
 
+    string init_kind, move_kind;
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--sampler" && i + 1 < argc)
+            init_kind = argv[++i];
+        else if(arg == "--move-sampler" && i + 1 < argc)
+            move_kind = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+    Sampler *init_sampler = init_kind.empty() ? NULL : new Sampler(init_kind, 2, rand());
+    Sampler *move_sampler = move_kind.empty() ? NULL : new Sampler(move_kind, 2, rand());
+
     string mode = "min";
 
     // 收集實驗數據用於計算平均和最大最小值範圍
-    vector<float> total_fitness, total_iter, total_x1, total_x2;
-    vector<float> real_total_iter;
+    StreamStats total_fitness, total_iter, total_x1, total_x2;
+    StreamStats real_total_iter;
     // 收集數據之實驗次數
     int exp_num=1;
     for(int exp=0;exp<exp_num;exp++){
@@ -162,6 +220,9 @@ int main(){
                 max_bound,
                 precision,
                 temperature);
+            ga.fitness_expr = fitness_expr;
+            ga.init_sampler = init_sampler;
+            ga.move_sampler = move_sampler;
 
             cout<<exp<<" temperature: "<<temperature<<"\n";
 
@@ -181,29 +242,31 @@ int main(){
                 // cout<<"x2: "<<ga.best_node.x2<<"\n";
                 // cout<<"fitness: "<<ga.best_node.fitness<<"\n";
                 // cout<<"=====\n";
-                total_iter.push_back(ga.best_iter);
+                total_iter.add(ga.best_iter);
                 iter++;
             }
             // cout<<iter<<"\n";
         }
-        total_fitness.push_back(best_one.fitness);
-        total_x1.push_back(best_one.x1);
-        total_x2.push_back(best_one.x2);
-        real_total_iter.push_back(find_sum(total_iter)/iter);
-        total_iter.clear();
+        total_fitness.add(best_one.fitness);
+        total_x1.add(best_one.x1);
+        total_x2.add(best_one.x2);
+        real_total_iter.add(total_iter.mean);
+        total_iter = StreamStats();
     }
     cout<<"===\n";
     cout<<"|name|stats|\n";
     cout<<"|-|-|\n";
-    cout<<"|fitness mean| "<<setprecision(6)<<find_sum(total_fitness)/ exp_num<<"|\n";
-    cout<<"|iter mean   | "<<find_sum(real_total_iter) / exp_num<<"|\n";
-    cout<<"|x1 mean     | "<<setprecision(4)<<find_sum(total_x1) / exp_num<<"|\n";
-    cout<<"|x2 mean     | "<<setprecision(4)<<find_sum(total_x2) / exp_num<<"|\n";
+    cout<<"|fitness mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+    cout<<"|iter mean   | "<<real_total_iter.mean<<"|\n";
+    cout<<"|x1 mean     | "<<setprecision(4)<<total_x1.mean<<"|\n";
+    cout<<"|x2 mean     | "<<setprecision(4)<<total_x2.mean<<"|\n";
 
     // 計算 range (min, max).
     find_range(total_fitness, "fitness");
+    find_ci(total_fitness, "fitness");
     find_range(real_total_iter, "iter");
     find_range(total_x1, "x1");
     find_range(total_x2, "x2");
 
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,231 @@
+#include<iostream>
+#include<fstream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<cstdio>
+#include<cstdint>
+#include<vector>
+#include<climits>
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<random>
+#include<cfloat>
+#include"ga_util.h"
+#include"expr_vm.h"
+#include"dist_eval.h"
+#include"parallel.h"
+#include"elite_archive.h"
+#include"rate_control.h"
+#include"anytime.h"
+#include"surrogate.h"
+#include"peak_finder.h"
+#include"local_search.h"
+#include"low_discrepancy.h"
+using namespace std;
+
+// Anytime benchmark: 四個 solver 以相同的 evaluation budget 各跑 runs 個 seed,
+// 記錄對數間隔 checkpoint 上的 best-so-far, 再算出 time-to-target 的 ECDF:
+//   targets: 所有 run 中最好的值 f_best 往回 span * 10^-j (j = 0 ... n_targets-1),
+//            span 為 f_best 與第一個 checkpoint 最差值的差;
+//   ecdf[s][k]: solver s 在第 checkpoints[k] 次 evaluation 時, 達到 target 的 (run, target) 比例.
+// HillClimbing 與 Anneling 提早停止時以新的起點重新開始, 直到用完 budget.
+//
+// 輸出檔: ANYTIME_HEADER bytes 的文字 header
+//   "GAECDF1\nsolvers name ...\nruns R\ncheckpoints K\ntargets T\n" (其餘補 '\0'),
+// 之後依序為 int64 checkpoints[K], float64 targets[T],
+// float32 traces[S][R][K], float32 ecdf[S][K].
+
+#define GA_NO_MAIN
+namespace ga_float_ns{
+#include"ga_float.cpp"
+}
+namespace ga_binary_ns{
+#include"ga_binary_string.cpp"
+}
+namespace hill_climbing_ns{
+#include"hill_climbing.cpp"
+}
+namespace anneling_ns{
+#include"anneling.cpp"
+}
+
+const int ANYTIME_HEADER = 1024;
+
+struct BenchConfig{
+    long budget = 100000;
+    int runs = 25, per_decade = 10, n_targets = 8;
+    float min_bound = 0, max_bound = 1;
+    string mode = "max";
+    ExprVM *fitness_expr = NULL;
+};
+
+// 一個 solver 跑一個 seed, 直到 trace 用完 budget.
+AnytimeTrace run_solver(string name, BenchConfig &cfg, int seed){
+    AnytimeTrace trace(cfg.mode, cfg.budget, cfg.per_decade);
+    srand(seed + 1);    // glibc 的 srand(0) 與 srand(1) 相同, seed 由 0 開始所以加 1.
+    if(name == "GAFloat"){
+        int population_size = 100;
+        ga_float_ns::GAFloat ga(cfg.budget / population_size, population_size, cfg.min_bound, cfg.max_bound, 0.0001, 0.01, 0.25);
+        ga.fitness_expr = cfg.fitness_expr;
+        ga.elite_size = 2;
+        ga.trace = &trace;
+        ga.run(cfg.mode, 5);
+    }
+    else if(name == "GABinaryString"){
+        int population_size = 50;
+        ga_binary_ns::GABinaryString<0> ga(cfg.budget / population_size, population_size, cfg.min_bound, cfg.max_bound, 0.0001, 0.01, 0.25, "gray");
+        ga.fitness_expr = cfg.fitness_expr;
+        ga.elite_size = 2;
+        ga.trace = &trace;
+        ga.run(cfg.mode, 5);
+    }
+    else if(name == "HillClimbing"){
+        while(!trace.exhausted()){
+            hill_climbing_ns::HillClimbing hc(1000, cfg.min_bound, cfg.max_bound, 0.01);
+            hc.fitness_expr = cfg.fitness_expr;
+            hc.trace = &trace;
+            hc.run(cfg.mode);
+        }
+    }
+    else{
+        while(!trace.exhausted()){
+            anneling_ns::Anneling sa(1000, cfg.min_bound, cfg.max_bound, 0.01, 100);
+            sa.fitness_expr = cfg.fitness_expr;
+            sa.trace = &trace;
+            sa.run(cfg.mode);
+        }
+    }
+    trace.finish();
+    return trace;
+}
+
+// ./anytime.out [--runs R] [--budget B] [--per-decade K] [--targets T] [--mode max|min]
+//               [--out FILE] ["fitness expression" [min_bound max_bound]]
+int main(int argc, char *argv[]){
+    BenchConfig cfg;
+    string out_path = "anytime.ecdf";
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--runs" && i + 1 < argc)
+            cfg.runs = atoi(argv[++i]);
+        else if(arg == "--budget" && i + 1 < argc)
+            cfg.budget = atol(argv[++i]);
+        else if(arg == "--per-decade" && i + 1 < argc)
+            cfg.per_decade = atoi(argv[++i]);
+        else if(arg == "--targets" && i + 1 < argc)
+            cfg.n_targets = atoi(argv[++i]);
+        else if(arg == "--mode" && i + 1 < argc)
+            cfg.mode = argv[++i];
+        else if(arg == "--out" && i + 1 < argc)
+            out_path = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    if(args.size() > 0)
+        cfg.fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        cfg.min_bound = atof(args[1].c_str());
+        cfg.max_bound = atof(args[2].c_str());
+    }
+    auto better = [&cfg](double a, double b){ return (cfg.mode == "max") ? a > b : a < b; };
+
+    vector<string> solvers = {"GAFloat", "GABinaryString", "HillClimbing", "Anneling"};
+    int n_solvers = solvers.size();
+    vector<vector<AnytimeTrace>> traces(n_solvers);
+
+    // solver 內部的輸出都丟掉.
+    ofstream null_stream("/dev/null");
+    streambuf *console = cout.rdbuf();
+    for(int s=0;s<n_solvers;s++){
+        auto start = chrono::steady_clock::now();
+        cout.rdbuf(null_stream.rdbuf());
+        for(int r=0;r<cfg.runs;r++)
+            traces[s].push_back(run_solver(solvers[s], cfg, r));
+        cout.rdbuf(console);
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout<<solvers[s]<<": "<<cfg.runs<<" runs in "<<elapsed<<"s\n";
+    }
+    vector<long> &checkpoints = traces[0][0].checkpoints;
+    int n_points = checkpoints.size();
+
+    // Targets.
+    double f_best = traces[0][0].trace.back(), f_worst = traces[0][0].trace[0];
+    for(auto &runs: traces)
+        for(AnytimeTrace &t: runs){
+            if(better(t.trace.back(), f_best))
+                f_best = t.trace.back();
+            if(better(f_worst, t.trace[0]))
+                f_worst = t.trace[0];
+        }
+    double span = fabs(f_best - f_worst);
+    vector<double> targets;
+    for(int j=0;j<cfg.n_targets;j++)
+        targets.push_back((cfg.mode == "max") ? f_best - span * pow(10.0, -j) : f_best + span * pow(10.0, -j));
+
+    // ECDF.
+    vector<vector<float>> ecdf(n_solvers, vector<float>(n_points, 0));
+    for(int s=0;s<n_solvers;s++){
+        for(AnytimeTrace &t: traces[s])
+            for(int k=0;k<n_points;k++)
+                for(double target: targets)
+                    if(!better(target, t.trace[k]))
+                        ecdf[s][k]++;
+        for(int k=0;k<n_points;k++)
+            ecdf[s][k] /= cfg.runs * cfg.n_targets;
+    }
+
+    // 寫檔.
+    string head = "GAECDF1\nsolvers";
+    for(string name: solvers)
+        head += " " + name;
+    head += "\nruns " + to_string(cfg.runs) + "\ncheckpoints " + to_string(n_points) +
+            "\ntargets " + to_string(cfg.n_targets) + "\n";
+    head.resize(ANYTIME_HEADER, '\0');
+    FILE *fp = fopen(out_path.c_str(), "wb");
+    if(fp == NULL){
+        cout<<"cannot write "<<out_path<<"\n";
+        return 1;
+    }
+    fwrite(head.data(), 1, head.size(), fp);
+    for(long e: checkpoints){
+        int64_t v = e;
+        fwrite(&v, sizeof(v), 1, fp);
+    }
+    fwrite(targets.data(), sizeof(double), targets.size(), fp);
+    for(auto &runs: traces)
+        for(AnytimeTrace &t: runs){
+            vector<float> values(t.trace.begin(), t.trace.end());
+            fwrite(values.data(), sizeof(float), values.size(), fp);
+        }
+    for(auto &curve: ecdf)
+        fwrite(curve.data(), sizeof(float), curve.size(), fp);
+    fclose(fp);
+
+    // 每個 10 倍的 budget 列出 ECDF, 與該 budget 下最好的 solver.
+    cout<<"f_best: "<<setprecision(8)<<f_best<<", targets down to "<<setprecision(3)<<span * pow(10.0, 1 - cfg.n_targets)<<" away\n";
+    cout<<"|evaluations|";
+    for(string name: solvers)
+        cout<<name<<"|";
+    cout<<"best|\n|-|";
+    for(int s=0;s<n_solvers;s++)
+        cout<<"-|";
+    cout<<"-|\n";
+    for(int k=0;k<n_points;k++){
+        long decade = 1;
+        while(decade < checkpoints[k])
+            decade *= 10;
+        if(k != n_points - 1 && decade != checkpoints[k])
+            continue;
+        int best = 0;
+        cout<<"|"<<checkpoints[k]<<"|";
+        for(int s=0;s<n_solvers;s++){
+            cout<<setprecision(3)<<ecdf[s][k]<<"|";
+            if(ecdf[s][k] > ecdf[best][k])
+                best = s;
+        }
+        cout<<solvers[best]<<"|\n";
+    }
+    cout<<"-> "<<out_path<<"\n";
+}
@@ -0,0 +1,72 @@
+#ifndef ANYTIME_H
+#define ANYTIME_H
+#include<cmath>
+#include<cfloat>
+#include<string>
+#include<vector>
+using namespace std;
+
+// 記錄 best-so-far 隨 evaluation 次數的變化 (anytime performance).
+// solver 每算一次 fitness 就呼叫 record(), 在對數間隔的 checkpoint
+// (每個 10 倍有 per_decade 個) 存下當時的 best-so-far, 所以記憶體只與 log(budget) 成正比.
+class AnytimeTrace{
+public:
+    string mode;
+    long n_evals = 0;
+    double best;
+    vector<long> checkpoints;
+    vector<double> trace;       // trace[k]: 第 checkpoints[k] 次 evaluation 後的 best-so-far.
+    AnytimeTrace(string mode, long budget, int per_decade = 10);
+    void record(double fitness);
+    template<class Cell> void record(const vector<Cell> &population);
+    bool exhausted();
+    void finish();
+};
+
+// 1, 2, ..., 以 10^(k / per_decade) 取整數, 重複的去掉, 最後一個為 budget.
+vector<long> log_checkpoints(long budget, int per_decade){
+    vector<long> points;
+    for(int k=0;;k++){
+        long e = llround(pow(10.0, (double)k / per_decade));
+        if(e >= budget)
+            break;
+        if(points.empty() || e > points.back())
+            points.push_back(e);
+    }
+    points.push_back(budget);
+    return points;
+}
+
+AnytimeTrace::AnytimeTrace(string mode, long budget, int per_decade){
+    this->mode = mode;
+    best = (mode == "max") ? -DBL_MAX : DBL_MAX;
+    checkpoints = log_checkpoints(budget, per_decade);
+    trace.reserve(checkpoints.size());
+}
+
+void AnytimeTrace::record(double fitness){
+    n_evals++;
+    if((mode == "max") ? fitness > best : fitness < best)
+        best = fitness;
+    while(trace.size() < checkpoints.size() && checkpoints[trace.size()] <= n_evals)
+        trace.push_back(best);
+}
+
+// population 裡的個體依序當作各算了一次.
+template<class Cell>
+void AnytimeTrace::record(const vector<Cell> &population){
+    for(const Cell &node: population)
+        record(node.fitness);
+}
+
+bool AnytimeTrace::exhausted(){
+    return trace.size() == checkpoints.size();
+}
+
+// solver 在 budget 之前就停止時, 之後的 checkpoint 都是最後的 best-so-far.
+void AnytimeTrace::finish(){
+    while(trace.size() < checkpoints.size())
+        trace.push_back(best);
+}
+
+#endif
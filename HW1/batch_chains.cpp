@@ -0,0 +1,354 @@
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<cstdint>
+#include<cstring>
+#include<vector>
+#include<climits>
+#include<chrono>
+#include"ga_util.h"
+#include"expr_vm.h"
+#include"fitness.h"
+#include"anytime.h"
+#include"low_discrepancy.h"
+using namespace std;
+
+// 一次推進很多條獨立的 HillClimbing / Anneling chain (multi-start), 每條 chain 佔
+// lane 陣列的一格: 位置, fitness, 溫度與 RNG 狀態都是 structure of arrays, 每一步
+//   1. 對所有 chain 同時產生 30 個鄰居 (與 move() 相同, ±precision 再 check_bound);
+//   2. lanes * 30 個點一次交給 BatchKernel;
+//   3. 以比較結果當 mask 選出每條 chain 最好的鄰居, 再依 run() 的規則決定接受或停止.
+// 這些迴圈都沒有分支, g++ -O3 會把每個 lane 放進一個 SIMD 元素.
+// 內建 fitness 的時間幾乎都在 pow / sin, 必須以 -O3 -march=native -ffast-math 編譯
+// (glibc 的向量版 libm), --compare 的 speedup 約 6 ~ 7x; 只用 -O2 時只有約 1.7x.
+// 停止的 chain 把結果寫到 results, 空出來的 lane 立刻換上下一條 chain;
+// chain 發完之後把最後一個 lane 搬進空位, 只計算還在跑的 n_active 個 lane.
+// 每條 chain 有自己的 xorshift128+ 狀態, 由 seed 與 chain 編號決定, 結果與分到哪個 lane 無關.
+
+// 64-byte 對齊, 相鄰 chain 的資料剛好落在同一個 SIMD register.
+template<class T>
+struct LaneAllocator{
+    typedef T value_type;
+    LaneAllocator() = default;
+    template<class U> LaneAllocator(const LaneAllocator<U>&){}
+    T *allocate(size_t n){ return (T*)aligned_alloc(64, (n * sizeof(T) + 63) / 64 * 64); }
+    void deallocate(T *p, size_t){ free(p); }
+};
+template<class T, class U> bool operator==(const LaneAllocator<T>&, const LaneAllocator<U>&){ return true; }
+template<class T, class U> bool operator!=(const LaneAllocator<T>&, const LaneAllocator<U>&){ return false; }
+template<class T> using lane_vector = vector<T, LaneAllocator<T>>;
+
+struct ChainResult{
+    double x1, x2;
+    double fitness;
+    int best_iter;
+    float temperature;
+};
+
+class BatchChains{
+public:
+    string kind;            // "hill" or "anneal".
+    int lanes, max_iter, n_neighbors = 30;
+    int n_active = 0;           // 還在跑的 lane 數, 都放在陣列的前面.
+    float min_bound, max_bound, precision;
+    BatchKernel fitness;
+    uint64_t seed;
+    lane_vector<double> cur_x1, cur_x2, cur_f, best_x1, best_x2, best_f, temp, rnd;
+    lane_vector<double> nb;     // 2 * n_neighbors * lanes: 所有鄰居的 x1, 之後是 x2.
+    lane_vector<double> nb_f;
+    lane_vector<uint64_t> s0, s1;   // 每條 chain 的 xorshift128+ 狀態.
+    lane_vector<int64_t> stop;      // 這一步之後停止的 chain (mask).
+    vector<int> iter, best_iter, chain_id;
+    vector<float> temperatures;     // 每條 chain 的溫度, 順序即 chain 編號.
+    vector<ChainResult> results;
+    long n_evals = 0;
+    BatchChains(string kind, int lanes, int max_iter, float min_bound, float max_bound, float precision, BatchKernel fitness, uint64_t seed);
+    void run(string mode, vector<float> temperatures);
+    void start(int lane, int id);
+    void uniform(double *out, double lo, double hi);
+    void step(string mode);
+    void move_lane(int from, int to);
+};
+
+BatchChains::BatchChains(string kind, int lanes, int max_iter, float min_bound, float max_bound, float precision, BatchKernel fitness, uint64_t seed){
+    if(kind != "hill" && kind != "anneal")
+        throw runtime_error("unknown chain kind: " + kind);
+    this->kind = kind;
+    this->lanes = lanes;
+    this->max_iter = max_iter;
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    this->precision = precision;
+    this->fitness = fitness;
+    this->seed = seed;
+}
+
+uint64_t splitmix64(uint64_t x){
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 每個 lane 抽一個 [lo, hi) 的亂數. 53 bit 放進 [1, 2) 的 double 再減 1, 不需要整數轉浮點.
+void BatchChains::uniform(double *out, double lo, double hi){
+    uint64_t *a = s0.data(), *b = s1.data();
+    for(int c=0;c<n_active;c++){
+        uint64_t x = a[c], y = b[c];
+        a[c] = y;
+        x ^= x << 23;
+        b[c] = x ^ y ^ (x >> 17) ^ (y >> 26);
+        uint64_t bits = ((b[c] + y) >> 12) | 0x3FF0000000000000ULL;
+        double u;
+        memcpy(&u, &bits, sizeof(u));
+        out[c] = lo + (hi - lo) * (u - 1);
+    }
+}
+
+// 在 lane 上開始第 id 條 chain: 與 initialize() + evaluate(cur_node) 相同.
+void BatchChains::start(int lane, int id){
+    chain_id[lane] = id;
+    iter[lane] = best_iter[lane] = 0;
+    s0[lane] = splitmix64(seed ^ (2 * (uint64_t)id));
+    s1[lane] = splitmix64(seed ^ (2 * (uint64_t)id + 1));
+    temp[lane] = temperatures[id];
+    for(int k=0;k<2;k++){
+        uint64_t x = s0[lane], y = s1[lane];
+        s0[lane] = y;
+        x ^= x << 23;
+        s1[lane] = x ^ y ^ (x >> 17) ^ (y >> 26);
+        double u = ((s1[lane] + y) >> 11) * 0x1.0p-53;
+        (k == 0 ? cur_x1 : cur_x2)[lane] = min_bound + (max_bound - min_bound) * u;
+    }
+    double cols[2] = {cur_x1[lane], cur_x2[lane]};
+    fitness(cols, 1, 2, &cur_f[lane]);
+    n_evals++;
+    best_x1[lane] = cur_x1[lane];
+    best_x2[lane] = cur_x2[lane];
+    best_f[lane] = cur_f[lane];
+}
+
+void BatchChains::step(string mode){
+    const bool maximize = (mode == "max");
+    const int K = n_neighbors, L = n_active;
+    double lo = min_bound, hi = max_bound;
+
+    // 1. 鄰居.
+    for(int j=0;j<K;j++){
+        double *x1 = &nb[(size_t)j * L], *x2 = &nb[(size_t)(K + j) * L];
+        uniform(x1, -precision, precision);
+        uniform(x2, -precision, precision);
+        for(int c=0;c<L;c++){
+            x1[c] = min(max(cur_x1[c] + x1[c], lo), hi);
+            x2[c] = min(max(cur_x2[c] + x2[c], lo), hi);
+        }
+    }
+    // 2. 一次算完.
+    fitness(nb.data(), K * L, 2, nb_f.data());
+    n_evals += (long)K * L;
+
+    // 3. 每條 chain 最好的鄰居成為 cur (find_best).
+    for(int c=0;c<L;c++){
+        cur_x1[c] = nb[c];
+        cur_x2[c] = nb[(size_t)K * L + c];
+        cur_f[c] = nb_f[c];
+    }
+    for(int j=1;j<K;j++){
+        const double *x1 = &nb[(size_t)j * L], *x2 = &nb[(size_t)(K + j) * L], *f = &nb_f[(size_t)j * L];
+        for(int c=0;c<L;c++){
+            bool take = maximize ? f[c] > cur_f[c] : f[c] < cur_f[c];
+            cur_x1[c] = take ? x1[c] : cur_x1[c];
+            cur_x2[c] = take ? x2[c] : cur_x2[c];
+            cur_f[c] = take ? f[c] : cur_f[c];
+        }
+    }
+
+    // 4. 接受或停止, 與 HillClimbing::run / Anneling::run 的判斷相同.
+    if(kind == "anneal")
+        uniform(rnd.data(), 0, 1);
+    for(int c=0;c<L;c++){
+        bool improve = maximize ? cur_f[c] > best_f[c] : cur_f[c] < best_f[c];
+        bool give_up;
+        if(kind == "hill")
+            give_up = maximize || iter[c] > 0;    // HillClimbing 在 min 模式第一步不停止.
+        else
+            give_up = rnd[c] > exp((cur_f[c] - best_f[c]) / temp[c]);
+        best_x1[c] = improve ? cur_x1[c] : best_x1[c];
+        best_x2[c] = improve ? cur_x2[c] : best_x2[c];
+        best_f[c] = improve ? cur_f[c] : best_f[c];
+        iter[c]++;
+        best_iter[c] = improve ? iter[c] : best_iter[c];
+        stop[c] = (!improve && give_up) || iter[c] >= max_iter;
+    }
+}
+
+// temperatures 的每一個元素是一條 chain (hill 時忽略溫度).
+void BatchChains::run(string mode, vector<float> temperatures){
+    this->temperatures = temperatures;
+    int n_chains = temperatures.size();
+    lanes = max(1, min(lanes, n_chains));
+    for(lane_vector<double> *v: {&cur_x1, &cur_x2, &cur_f, &best_x1, &best_x2, &best_f, &temp, &rnd})
+        v->assign(lanes, 0);
+    nb.assign((size_t)2 * n_neighbors * lanes, 0);
+    nb_f.assign((size_t)n_neighbors * lanes, 0);
+    s0.assign(lanes, 0);
+    s1.assign(lanes, 0);
+    stop.assign(lanes, 0);
+    iter.assign(lanes, 0);
+    best_iter.assign(lanes, 0);
+    chain_id.assign(lanes, -1);
+    results.assign(n_chains, ChainResult());
+
+    int next = 0;
+    for(int c=0;c<lanes;c++)
+        start(c, next++);
+    n_active = lanes;
+    while(n_active > 0){
+        step(mode);
+        for(int c=0;c<n_active;){
+            if(!stop[c]){
+                c++;
+                continue;
+            }
+            results[chain_id[c]] = {best_x1[c], best_x2[c], best_f[c], best_iter[c], (float)temp[c]};
+            if(next < n_chains){
+                start(c, next++);
+                c++;
+            }
+            else{
+                // 沒有新的 chain: 最後一個 lane 搬進來, 它的 stop 還沒處理, 所以 c 不前進.
+                move_lane(n_active - 1, c);
+                n_active--;
+            }
+        }
+    }
+}
+
+void BatchChains::move_lane(int from, int to){
+    cur_x1[to] = cur_x1[from];
+    cur_x2[to] = cur_x2[from];
+    cur_f[to] = cur_f[from];
+    best_x1[to] = best_x1[from];
+    best_x2[to] = best_x2[from];
+    best_f[to] = best_f[from];
+    temp[to] = temp[from];
+    s0[to] = s0[from];
+    s1[to] = s1[from];
+    stop[to] = stop[from];
+    iter[to] = iter[from];
+    best_iter[to] = best_iter[from];
+    chain_id[to] = chain_id[from];
+}
+
+#ifndef GA_NO_MAIN
+#define GA_NO_MAIN
+namespace hill_climbing_ns{
+#include"hill_climbing.cpp"
+}
+namespace anneling_ns{
+#include"anneling.cpp"
+}
+
+// ./batch_chains.out [--kind hill|anneal] [--chains N] [--lanes L] [--mode max|min] [--compare]
+//                    ["fitness expression" [min_bound max_bound]]
+// hill: N 條 chain (預設與 hill_climbing.cpp 相同, 1000 條).
+// anneal: 溫度 100, 20, 4 各 N / 3 條 (與 anneling.cpp 的溫度相同).
+// --compare: 以 rand() 的 scalar 版本跑相同數量的 chain, 比較結果與速度.
+int main(int argc, char *argv[]){
+    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
+
+    string kind = "hill", mode = "min";
+    int n_chains = 1000, lanes = 256;
+    bool compare = false;
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--kind" && i + 1 < argc)
+            kind = argv[++i];
+        else if(arg == "--chains" && i + 1 < argc)
+            n_chains = atoi(argv[++i]);
+        else if(arg == "--lanes" && i + 1 < argc)
+            lanes = atoi(argv[++i]);
+        else if(arg == "--mode" && i + 1 < argc)
+            mode = argv[++i];
+        else if(arg == "--compare")
+            compare = true;
+        else
+            args.push_back(arg);
+    }
+    int max_iter=1000;
+    float min_bound=0, max_bound=1;
+    float precision=0.01;
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+    BatchKernel fitness = (fitness_expr != NULL) ? find_fitness(args[0], 2) : BatchKernel(hw1_fitness);
+
+    vector<float> temperatures;
+    for(int i=0;i<n_chains;i++)
+        temperatures.push_back((kind == "anneal") ? 100 * pow(0.2, i * 3 / n_chains) : 0);
+
+    BatchChains chains(kind, lanes, max_iter, min_bound, max_bound, precision, fitness, rand());
+    auto start = chrono::steady_clock::now();
+    chains.run(mode, temperatures);
+    double batch_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    StreamStats total_fitness, total_iter, total_x1, total_x2;
+    ChainResult best_one = chains.results[0];
+    for(ChainResult &r: chains.results){
+        total_fitness.add(r.fitness);
+        total_iter.add(r.best_iter);
+        if((mode == "max") ? r.fitness > best_one.fitness : r.fitness < best_one.fitness)
+            best_one = r;
+    }
+
+    cout<<"===\n";
+    cout<<"|name|stats|\n";
+    cout<<"|-|-|\n";
+    cout<<"|best fitness     | "<<setprecision(6)<<best_one.fitness<<"|\n";
+    cout<<"|best (x1, x2)    | "<<setprecision(4)<<best_one.x1<<", "<<best_one.x2<<"|\n";
+    cout<<"|chain fitness mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+    cout<<"|chain iter mean  | "<<total_iter.mean<<"|\n";
+    find_ci(total_fitness, "chain fitness");
+    find_range(total_iter, "chain iter");
+    cout<<"|chains / s       | "<<n_chains / batch_time<<"|\n";
+    cout<<"|evaluations      | "<<chains.n_evals<<"|\n";
+
+    if(compare){
+        // scalar 版本的輸出都丟掉.
+        streambuf *console = cout.rdbuf();
+        cout.rdbuf(NULL);
+        StreamStats scalar_fitness, scalar_iter;
+        start = chrono::steady_clock::now();
+        for(int i=0;i<n_chains;i++){
+            if(kind == "hill"){
+                hill_climbing_ns::HillClimbing hc(max_iter, min_bound, max_bound, precision);
+                hc.fitness_expr = fitness_expr;
+                scalar_fitness.add(hc.run(mode).fitness);
+                scalar_iter.add(hc.best_iter);
+            }
+            else{
+                anneling_ns::Anneling sa(max_iter, min_bound, max_bound, precision, temperatures[i]);
+                sa.fitness_expr = fitness_expr;
+                scalar_fitness.add(sa.run(mode).fitness);
+                scalar_iter.add(sa.best_iter);
+            }
+        }
+        double scalar_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout.rdbuf(console);
+        cout<<"|scalar fitness mean| "<<setprecision(6)<<scalar_fitness.mean<<"|\n";
+        cout<<"|scalar iter mean | "<<scalar_iter.mean<<"|\n";
+        find_ci(scalar_fitness, "scalar fitness");
+        cout<<"|scalar chains / s| "<<n_chains / scalar_time<<"|\n";
+        cout<<"|speedup          | "<<scalar_time / batch_time<<"|\n";
+    }
+
+    cout<<"\nNow mode: "<<mode<<endl;
+    cout<<"Batched "<<kind<<" chains ("<<chains.lanes<<" lanes)\n";
+}
+#endif
@@ -0,0 +1,269 @@
+#ifndef DIST_EVAL_H
+#define DIST_EVAL_H
+#include<iostream>
+#include<cstdint>
+#include<cstring>
+#include<cstdlib>
+#include<string>
+#include<vector>
+#include<map>
+#include<functional>
+#include<stdexcept>
+#include<unistd.h>
+#include<signal.h>
+#include<poll.h>
+#include<netdb.h>
+#include<sys/socket.h>
+#include<sys/wait.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include"fitness.h"
+using namespace std;
+
+// 把 fitness 的計算分給其他 process (同一台用 socketpair, 其他機器用 TCP).
+//
+// Wire format (native byte order):
+//   request : WireHeader{magic, batch_id, n, dim} + dim 個 column, 每個 n 個 double
+//   response: WireHeader{magic, batch_id, n, 1}   + n 個 fitness (double)
+//   n = 0 的 request 代表結束連線.
+
+const uint32_t WIRE_MAGIC = 0x56454147;     // "GAEV"
+
+struct WireHeader{
+    uint32_t magic;
+    uint32_t batch_id;
+    uint32_t n;
+    uint32_t dim;
+};
+
+bool read_full(int fd, void *buf, size_t len){
+    char *p = (char*)buf;
+    while(len > 0){
+        ssize_t r = read(fd, p, len);
+        if(r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+bool write_full(int fd, const void *buf, size_t len){
+    const char *p = (const char*)buf;
+    while(len > 0){
+        ssize_t r = write(fd, p, len);
+        if(r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+// Worker 的主迴圈: 收 batch, 算 fitness, 回傳, 直到收到 n = 0 或斷線.
+void serve_worker(int fd, BatchKernel kernel){
+    WireHeader head;
+    vector<double> cols, out;
+    while(read_full(fd, &head, sizeof(head)) && head.magic == WIRE_MAGIC && head.n > 0){
+        cols.resize((size_t)head.n * head.dim);
+        out.resize(head.n);
+        if(!read_full(fd, cols.data(), cols.size() * sizeof(double)))
+            break;
+        kernel(cols.data(), head.n, head.dim, out.data());
+        head.dim = 1;
+        if(!write_full(fd, &head, sizeof(head)) || !write_full(fd, out.data(), out.size() * sizeof(double)))
+            break;
+    }
+    close(fd);
+}
+
+// 給其他機器用: 在 port 上等 master 連線, 每個連線 fork 一個 worker.
+void serve_tcp(int port, BatchKernel kernel){
+    signal(SIGCHLD, SIG_IGN);
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if(bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, 16) < 0)
+        throw runtime_error("cannot listen on port " + to_string(port));
+    cout<<"Worker listening on port "<<port<<"\n";
+    while(true){
+        int fd = accept(sock, NULL, NULL);
+        if(fd < 0)
+            continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        if(fork() == 0){
+            close(sock);
+            serve_worker(fd, kernel);
+            _exit(0);
+        }
+        close(fd);
+    }
+}
+
+class DistEvaluator{
+public:
+    int max_inflight = 4;       // 每個 worker 最多同時排隊的 batch 數.
+    long n_batches = 0, n_individuals = 0;
+    DistEvaluator();
+    ~DistEvaluator();
+    void spawn_local(int n_workers, BatchKernel kernel);
+    void connect_tcp(string host, int port);
+    void submit(const double *cols, int n, int dim, double *out);
+    void wait_all();
+    void shutdown();
+    int num_workers();
+private:
+    struct Worker{
+        int fd;
+        pid_t pid;      // 本機 fork 出來的 worker, TCP 的為 -1.
+        int inflight;
+    };
+    struct Pending{
+        double *out;
+        int n, worker;
+    };
+    vector<Worker> workers;
+    map<uint32_t, Pending> pending;
+    uint32_t next_id = 0;
+    void receive_one();
+    void close_workers();
+};
+
+DistEvaluator::DistEvaluator(){
+    signal(SIGPIPE, SIG_IGN);
+}
+
+// 可能是在例外 unwind 的途中被呼叫, 所以不等還沒回來的 batch, 也不丟出例外:
+// 關掉連線後 worker 讀到 EOF (或寫入失敗) 就會結束.
+DistEvaluator::~DistEvaluator(){
+    close_workers();
+}
+
+int DistEvaluator::num_workers(){
+    return workers.size();
+}
+
+// 在本機 fork n_workers 個 process 模擬多台機器, 用 Unix domain socket 溝通.
+void DistEvaluator::spawn_local(int n_workers, BatchKernel kernel){
+    for(int i=0;i<n_workers;i++){
+        int fds[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+            throw runtime_error("socketpair failed");
+        cout.flush();
+        pid_t pid = fork();
+        if(pid == 0){
+            close(fds[0]);
+            for(Worker &w: workers)
+                close(w.fd);
+            serve_worker(fds[1], kernel);
+            _exit(0);
+        }
+        close(fds[1]);
+        workers.push_back({fds[0], pid, 0});
+    }
+}
+
+void DistEvaluator::connect_tcp(string host, int port){
+    addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &res) != 0)
+        throw runtime_error("cannot resolve " + host);
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if(fd < 0 || connect(fd, res->ai_addr, res->ai_addrlen) < 0){
+        freeaddrinfo(res);
+        throw runtime_error("cannot connect to " + host + ":" + to_string(port));
+    }
+    freeaddrinfo(res);
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    workers.push_back({fd, -1, 0});
+}
+
+// 送出一個 batch 後立刻返回, 結果在 wait_all() 之後寫入 out.
+// 所有 worker 都排滿時先收一個結果, 避免雙方互相卡在 write.
+void DistEvaluator::submit(const double *cols, int n, int dim, double *out){
+    if(workers.empty())
+        throw runtime_error("no workers");
+    int idx = 0;
+    for(int i=1;i<(int)workers.size();i++)
+        if(workers[i].inflight < workers[idx].inflight)
+            idx = i;
+    while(workers[idx].inflight >= max_inflight){
+        receive_one();
+        for(int i=0;i<(int)workers.size();i++)
+            if(workers[i].inflight < workers[idx].inflight)
+                idx = i;
+    }
+
+    WireHeader head = {WIRE_MAGIC, next_id, (uint32_t)n, (uint32_t)dim};
+    if(!write_full(workers[idx].fd, &head, sizeof(head)) ||
+       !write_full(workers[idx].fd, cols, (size_t)n * dim * sizeof(double)))
+        throw runtime_error("worker connection lost");
+    pending[next_id++] = {out, n, idx};
+    workers[idx].inflight++;
+    n_batches++;
+    n_individuals += n;
+}
+
+void DistEvaluator::receive_one(){
+    vector<pollfd> fds;
+    vector<int> owner;
+    for(int i=0;i<(int)workers.size();i++){
+        if(workers[i].inflight == 0)
+            continue;
+        fds.push_back({workers[i].fd, POLLIN, 0});
+        owner.push_back(i);
+    }
+    if(fds.empty())
+        return;
+    while(poll(fds.data(), fds.size(), -1) < 0);
+
+    for(int k=0;k<(int)fds.size();k++){
+        if(!(fds[k].revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+        WireHeader head;
+        if(!read_full(fds[k].fd, &head, sizeof(head)) || head.magic != WIRE_MAGIC || !pending.count(head.batch_id))
+            throw runtime_error("worker connection lost");
+        Pending job = pending[head.batch_id];
+        if(head.n != (uint32_t)job.n || head.dim != 1 || job.worker != owner[k])
+            throw runtime_error("worker sent a bad response for batch " + to_string(head.batch_id));
+        if(!read_full(fds[k].fd, job.out, (size_t)job.n * sizeof(double)))
+            throw runtime_error("worker connection lost");
+        pending.erase(head.batch_id);
+        workers[owner[k]].inflight--;
+        return;
+    }
+}
+
+void DistEvaluator::wait_all(){
+    while(!pending.empty())
+        receive_one();
+}
+
+void DistEvaluator::shutdown(){
+    wait_all();
+    close_workers();
+}
+
+void DistEvaluator::close_workers(){
+    WireHeader bye = {WIRE_MAGIC, 0, 0, 0};
+    for(Worker &w: workers){
+        // 還有 batch 沒收回時 worker 可能正卡在 write, 不送結束訊息, 直接關掉.
+        if(w.inflight == 0)
+            write_full(w.fd, &bye, sizeof(bye));
+        close(w.fd);
+        if(w.pid > 0)
+            waitpid(w.pid, NULL, 0);
+    }
+    workers.clear();
+    pending.clear();
+}
+
+#endif
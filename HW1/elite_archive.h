@@ -0,0 +1,73 @@
+#ifndef ELITE_ARCHIVE_H
+#define ELITE_ARCHIVE_H
+#include<vector>
+#include<string>
+#include<algorithm>
+#include<functional>
+#include<unordered_set>
+using namespace std;
+
+// 保留目前為止最好的 capacity 個不重複個體 (hall of fame).
+// heap 的頂端是 archive 裡最差的 elite, 新個體只需與它比較, 插入為 O(log k).
+// 以 hash_fn 算出的 genome hash 去除重複的個體.
+template<class Cell>
+class EliteArchive{
+public:
+    int capacity = 0;
+    string mode;
+    vector<Cell> heap;
+    Cell best_cell;
+    EliteArchive(){}
+    EliteArchive(int capacity, string mode, function<size_t(const Cell&)> hash_fn);
+    bool offer(const Cell &node);
+    bool better(const Cell &a, const Cell &b);
+    int size();
+private:
+    function<size_t(const Cell&)> hash_fn;
+    unordered_set<size_t> hashes;
+};
+
+template<class Cell>
+EliteArchive<Cell>::EliteArchive(int capacity, string mode, function<size_t(const Cell&)> hash_fn){
+    this->capacity = capacity;
+    this->mode = mode;
+    this->hash_fn = hash_fn;
+    heap.reserve(capacity);
+}
+
+template<class Cell>
+bool EliteArchive<Cell>::better(const Cell &a, const Cell &b){
+    return (mode == "max") ? a.fitness > b.fitness : a.fitness < b.fitness;
+}
+
+template<class Cell>
+int EliteArchive<Cell>::size(){
+    return heap.size();
+}
+
+// 若 node 進入 archive 則回傳 true.
+template<class Cell>
+bool EliteArchive<Cell>::offer(const Cell &node){
+    if(capacity <= 0)
+        return false;
+    auto worst_on_top = [this](const Cell &a, const Cell &b){ return better(a, b); };
+    if((int)heap.size() == capacity && !better(node, heap.front()))
+        return false;
+    size_t h = hash_fn(node);
+    if(hashes.count(h))
+        return false;
+
+    if((int)heap.size() == capacity){
+        pop_heap(heap.begin(), heap.end(), worst_on_top);
+        hashes.erase(hash_fn(heap.back()));
+        heap.pop_back();
+    }
+    heap.push_back(node);
+    push_heap(heap.begin(), heap.end(), worst_on_top);
+    hashes.insert(h);
+    if(heap.size() == 1 || better(node, best_cell))
+        best_cell = node;
+    return true;
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<vector>
+#include<algorithm>
+#define GA_NO_MAIN
+#include"ga_float.cpp"
+using namespace std;
+
+// 連續問題的另外兩個 solver, 與 GAFloat 共用 population, rand(), evaluate()
+// (包括 fitness_expr / dist), find_best() 與 trace:
+//   DiffEvolution: DE/rand/1/bin, trial vector 放在 pool, 與 population 逐一比較.
+//   CMAES: (mu/mu_w, lambda)-CMA-ES, population_size 即 lambda, 每個 generation
+//          一次抽出 lambda 個樣本再一起 evaluate, covariance 以 rank-one + rank-mu 更新.
+// 總 evaluation 數: DE 為 (max_iter + 1) * population_size (含初始 population),
+// CMAES 為 max_iter * population_size, 收斂後以加倍的 lambda 重新開始 (IPOP).
+
+class DiffEvolution: public GAFloat{
+public:
+    float F = 0.5;      // difference vector 的倍率.
+    float CR = 0.9;     // 每個座標取自 mutant 的機率.
+    DiffEvolution(int max_iter, int population_size, float min_bound, float max_bound, float precision);
+    void run(string mode);
+};
+
+DiffEvolution::DiffEvolution(int max_iter, int population_size, float min_bound, float max_bound, float precision)
+    : GAFloat(max_iter, population_size, min_bound, max_bound, precision, 0, 0){
+}
+
+void DiffEvolution::run(string mode){
+    best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
+    initialize();
+    evaluate();
+    if(trace != NULL)
+        trace->record(population);
+    find_best(mode);
+    pool.resize(population_size);
+    for(int iter=0;iter<max_iter;iter++){
+        for(int i=0;i<population_size;i++){
+            int a, b, c;
+            do a = rand() % population_size; while(a == i);
+            do b = rand() % population_size; while(b == i || b == a);
+            do c = rand() % population_size; while(c == i || c == a || c == b);
+            double mutant[2] = {population[a].x1 + F * (population[b].x1 - population[c].x1),
+                                population[a].x2 + F * (population[b].x2 - population[c].x2)};
+            double parent[2] = {population[i].x1, population[i].x2};
+            int forced = rand() % 2;    // 至少一個座標來自 mutant.
+            double trial[2];
+            for(int d=0;d<2;d++){
+                trial[d] = (d == forced || (double)rand() / RAND_MAX < CR) ? mutant[d] : parent[d];
+                trial[d] = min(max(trial[d], (double)min_bound), (double)max_bound);
+            }
+            pool[i].x1 = trial[0];
+            pool[i].x2 = trial[1];
+        }
+        // evaluate() 只看 population, 交換後算 trial vector.
+        population.swap(pool);
+        evaluate();
+        if(trace != NULL)
+            trace->record(population);
+        population.swap(pool);
+
+        for(int i=0;i<population_size;i++)
+            if((mode == "max") ? pool[i].fitness >= population[i].fitness : pool[i].fitness <= population[i].fitness)
+                population[i] = pool[i];
+        best_gene_list.push_back(find_best(mode));
+    }
+    int iter_interval = 200;
+    print_info(iter_interval);
+}
+
+class CMAES: public GAFloat{
+public:
+    double mean[2], sigma;
+    double C[2][2] = {{1, 0}, {0, 1}};  // covariance.
+    double B[2][2] = {{1, 0}, {0, 1}};  // C 的 eigenvector (column).
+    double D[2] = {1, 1};               // C 的 eigenvalue 開根號.
+    double pc[2] = {0, 0}, ps[2] = {0, 0};
+    long n_evals = 0, best_eval = 0;    // best_eval: 找到 best_cell 時的 evaluation 數.
+    int n_restarts = 0;
+    vector<double> z1, z2, y1, y2;      // 這個 generation 的樣本, N(0, I) 與 B D z.
+    CMAES(int max_iter, int population_size, float min_bound, float max_bound, float precision);
+    void sample();
+    void update(string mode, int iter);
+    void eigen();
+    double randnormal();
+    void run(string mode);
+};
+
+CMAES::CMAES(int max_iter, int population_size, float min_bound, float max_bound, float precision)
+    : GAFloat(max_iter, max(population_size, 4), min_bound, max_bound, precision, 0, 0){
+}
+
+// Box-Muller, 與其他 solver 一樣用 rand().
+double CMAES::randnormal(){
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (double)rand() / RAND_MAX;
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+// 一次抽出 lambda 個樣本: 先產生整批 z, 再以 column 計算 y = B D z 與 x = mean + sigma y.
+void CMAES::sample(){
+    int n = population_size;
+    z1.resize(n);
+    z2.resize(n);
+    y1.resize(n);
+    y2.resize(n);
+    for(int k=0;k<n;k++){
+        z1[k] = randnormal();
+        z2[k] = randnormal();
+    }
+    double a11 = B[0][0] * D[0], a12 = B[0][1] * D[1], a21 = B[1][0] * D[0], a22 = B[1][1] * D[1];
+    for(int k=0;k<n;k++){
+        y1[k] = a11 * z1[k] + a12 * z2[k];
+        y2[k] = a21 * z1[k] + a22 * z2[k];
+    }
+    population.resize(n);
+    for(int k=0;k<n;k++){
+        cell &node = population[k];
+        node.x1 = min(max(mean[0] + sigma * y1[k], (double)min_bound), (double)max_bound);
+        node.x2 = min(max(mean[1] + sigma * y2[k], (double)min_bound), (double)max_bound);
+        // 超出範圍的樣本以實際位置更新, 不然 mean 會往範圍外走.
+        y1[k] = (node.x1 - mean[0]) / sigma;
+        y2[k] = (node.x2 - mean[1]) / sigma;
+    }
+}
+
+// 2x2 對稱矩陣的 eigen decomposition 有公式解, D[0] >= D[1].
+void CMAES::eigen(){
+    double a = C[0][0], b = C[0][1], c = C[1][1];
+    double half = (a - c) / 2, r = sqrt(half * half + b * b);
+    double l1 = (a + c) / 2 + r, l2 = (a + c) / 2 - r;
+    double theta = 0.5 * atan2(2 * b, a - c);
+    B[0][0] = cos(theta); B[0][1] = -sin(theta);
+    B[1][0] = sin(theta); B[1][1] = cos(theta);
+    D[0] = sqrt(max(l1, 1e-300));
+    D[1] = sqrt(max(l2, 1e-300));
+}
+
+// 參數取自 Hansen, "The CMA Evolution Strategy: A Tutorial" 的預設值.
+void CMAES::update(string mode, int iter){
+    const int n = 2;
+    int lambda = population_size, mu = lambda / 2;
+    vector<int> order(lambda);
+    for(int k=0;k<lambda;k++)
+        order[k] = k;
+    sort(order.begin(), order.end(), [&](int a, int b){
+        return (mode == "max") ? population[a].fitness > population[b].fitness : population[a].fitness < population[b].fitness;
+    });
+    vector<double> w(mu);
+    double sum_w = 0, sum_w2 = 0;
+    for(int i=0;i<mu;i++){
+        w[i] = log(mu + 0.5) - log(i + 1.0);
+        sum_w += w[i];
+    }
+    for(int i=0;i<mu;i++){
+        w[i] /= sum_w;
+        sum_w2 += w[i] * w[i];
+    }
+    double mueff = 1 / sum_w2;
+    double cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n),
+           cs = (mueff + 2) / (n + mueff + 5),
+           c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff),
+           cmu = min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff)),
+           damps = 1 + 2 * max(0.0, sqrt((mueff - 1) / (n + 1)) - 1) + cs,
+           chi_n = sqrt((double)n) * (1 - 1.0 / (4 * n) + 1.0 / (21 * n * n));
+
+    // 加權平均的 step 與 rank-mu 的 sum w y y^T 一起累加.
+    double yw[2] = {0, 0}, rank_mu[2][2] = {{0, 0}, {0, 0}};
+    for(int i=0;i<mu;i++){
+        int k = order[i];
+        yw[0] += w[i] * y1[k];
+        yw[1] += w[i] * y2[k];
+        rank_mu[0][0] += w[i] * y1[k] * y1[k];
+        rank_mu[0][1] += w[i] * y1[k] * y2[k];
+        rank_mu[1][1] += w[i] * y2[k] * y2[k];
+    }
+    rank_mu[1][0] = rank_mu[0][1];
+    mean[0] += sigma * yw[0];
+    mean[1] += sigma * yw[1];
+
+    // C^(-1/2) yw = B D^-1 B^T yw.
+    double t0 = (B[0][0] * yw[0] + B[1][0] * yw[1]) / D[0],
+           t1 = (B[0][1] * yw[0] + B[1][1] * yw[1]) / D[1];
+    double inv_sqrt_c[2] = {B[0][0] * t0 + B[0][1] * t1, B[1][0] * t0 + B[1][1] * t1};
+    double norm_s = sqrt(cs * (2 - cs) * mueff);
+    ps[0] = (1 - cs) * ps[0] + norm_s * inv_sqrt_c[0];
+    ps[1] = (1 - cs) * ps[1] + norm_s * inv_sqrt_c[1];
+    double ps_len = sqrt(ps[0] * ps[0] + ps[1] * ps[1]);
+    bool hsig = ps_len / sqrt(1 - pow(1 - cs, 2 * (iter + 1))) / chi_n < 1.4 + 2.0 / (n + 1);
+
+    double norm_c = sqrt(cc * (2 - cc) * mueff);
+    pc[0] = (1 - cc) * pc[0] + hsig * norm_c * yw[0];
+    pc[1] = (1 - cc) * pc[1] + hsig * norm_c * yw[1];
+
+    double keep = 1 - c1 - cmu + (1 - hsig) * c1 * cc * (2 - cc);
+    for(int r=0;r<2;r++)
+        for(int c=0;c<2;c++)
+            C[r][c] = keep * C[r][c] + c1 * pc[r] * pc[c] + cmu * rank_mu[r][c];
+
+    sigma *= exp((cs / damps) * (ps_len / chi_n - 1));
+    eigen();
+}
+
+// IPOP: 收斂 (step 遠小於 precision) 後從新的隨機位置重新開始, lambda 加倍,
+// 直到用完 max_iter * population_size 次 evaluation.
+void CMAES::run(string mode){
+    best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
+    long budget = (long)max_iter * population_size;
+    for(int lambda=population_size;n_evals + lambda <= budget;lambda*=2){
+        population_size = lambda;
+        mean[0] = randfloat(min_bound, max_bound);
+        mean[1] = randfloat(min_bound, max_bound);
+        sigma = 0.3 * (max_bound - min_bound);
+        C[0][0] = C[1][1] = B[0][0] = B[1][1] = D[0] = D[1] = 1;
+        C[0][1] = C[1][0] = B[0][1] = B[1][0] = 0;
+        pc[0] = pc[1] = ps[0] = ps[1] = 0;
+        for(int iter=0;n_evals + lambda <= budget;iter++){
+            sample();
+            evaluate();
+            n_evals += lambda;
+            if(trace != NULL)
+                trace->record(population);
+            double prev_best = best_cell.fitness;
+            best_gene_list.push_back(find_best(mode));
+            if(best_cell.fitness != prev_best)
+                best_eval = n_evals;
+            update(mode, iter);
+            // 步長遠小於 precision 之後已經不會再進步; C 的 condition number 太大時數值不穩定.
+            if(sigma * D[0] < 1e-3 * precision || D[0] > 1e7 * D[1] || !isfinite(sigma))
+                break;
+        }
+        n_restarts++;
+    }
+    int iter_interval = 200;
+    print_info(iter_interval);
+}
+
+#ifndef EVOLUTION_NO_MAIN
+// ./evolution.out [--engine ga|de|cmaes] [--evals N] [--mode max|min] ["fitness expression" [min_bound max_bound]]
+// 以相同的 evaluation 上限跑 exp_num 次, 比較結果與找到最好值時用掉的 evaluation 數.
+int main(int argc, char *argv[]){
+    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
+
+    string engine = "cmaes", mode = "max";
+    long evals = 100000;
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--engine" && i + 1 < argc)
+            engine = argv[++i];
+        else if(arg == "--evals" && i + 1 < argc)
+            evals = atol(argv[++i]);
+        else if(arg == "--mode" && i + 1 < argc)
+            mode = argv[++i];
+        else
+            args.push_back(arg);
+    }
+
+    float min_bound=0, max_bound=1;
+    float precision=0.0001, p_mutation=0.01, p_crossover=0.25;
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+
+    // 收集實驗數據用於計算平均和最大最小值範圍
+    StreamStats total_fitness, total_evals, total_x1, total_x2;
+    // 收集數據之實驗次數
+    int exp_num=10;
+    // best_iter 以 generation 計, 初始的 population 是第 1 個.
+    auto collect = [&](GAFloat &solver, long used){
+        total_fitness.add(solver.best_cell.fitness);
+        total_evals.add(used);
+        total_x1.add(solver.best_cell.x1);
+        total_x2.add(solver.best_cell.x2);
+    };
+    for(int exp=0;exp<exp_num;exp++){
+        if(engine == "de"){
+            DiffEvolution de(evals / 20 - 1, 20, min_bound, max_bound, precision);
+            de.fitness_expr = fitness_expr;
+            de.run(mode);
+            collect(de, (long)de.best_iter * de.population_size);
+        }
+        else if(engine == "cmaes"){
+            CMAES es(evals / 6, 6, min_bound, max_bound, precision);
+            es.fitness_expr = fitness_expr;
+            es.run(mode);
+            collect(es, es.best_eval);
+        }
+        else{
+            GAFloat ga(evals / 100 - 1, 100, min_bound, max_bound, precision, p_mutation, p_crossover);
+            ga.fitness_expr = fitness_expr;
+            ga.elite_size = 2;
+            ga.run(mode, 5);
+            collect(ga, (long)ga.best_iter * ga.population_size);
+        }
+    }
+
+    cout<<"===\n";
+    cout<<"|name|stats|\n";
+    cout<<"|-|-|\n";
+    cout<<"|fitness mean| "<<setprecision(8)<<total_fitness.mean<<"|\n";
+    cout<<"|evals mean  | "<<setprecision(6)<<total_evals.mean<<"|\n";
+    cout<<"|x1 mean     | "<<setprecision(6)<<total_x1.mean<<"|\n";
+    cout<<"|x2 mean     | "<<setprecision(6)<<total_x2.mean<<"|\n";
+
+    find_range(total_fitness, "fitness");
+    find_ci(total_fitness, "fitness");
+    find_range(total_evals, "evals");
+    find_range(total_x1, "x1");
+    find_range(total_x2, "x2");
+
+    cout<<"\n Now mode: "<<mode<<endl;
+    cout<<"Engine: "<<engine<<endl;
+}
+#endif
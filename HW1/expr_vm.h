@@ -0,0 +1,307 @@
+#ifndef EXPR_VM_H
+#define EXPR_VM_H
+#include<iostream>
+#include<cmath>
+#include<cctype>
+#include<cstdlib>
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<stdexcept>
+using namespace std;
+
+// Fitness 運算式的 bytecode.
+// 語法: + - * / ^ (或 **), 一元負號, 括號, 數字, 常數 pi, e,
+// 變數 x1, x2, ... (x, y, z 為 x1, x2, x3 的別名),
+// 函數 sin cos tan exp log sqrt abs pow(a, b).
+// 例如: 80 - x^2 - y^2 + 10*cos(2*pi*x) + 10*cos(2*pi*y)
+enum OpCode{
+    OP_CONST, OP_VAR,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW, OP_NEG, OP_SQUARE,
+    OP_SIN, OP_COS, OP_TAN, OP_EXP, OP_LOG, OP_SQRT, OP_ABS
+};
+
+struct Instr{
+    OpCode op;
+    int arg;        // OP_VAR 的變數編號.
+    double val;     // OP_CONST 的常數值.
+};
+
+class ExprVM{
+public:
+    static constexpr int BLOCK = 256;   // 每次一個 opcode 處理的個體數.
+    string src;
+    vector<string> var_names;
+    vector<Instr> code;
+    int max_depth;
+    ExprVM(string src, vector<string> var_names = {"x1", "x2"});
+    void run(const vector<const double*> &vars, double *out, int n);
+    double eval(const vector<double> &vars);
+    double eval(double x1, double x2);
+    void print_code();
+private:
+    int pos, depth;
+    void emit(OpCode op, int arg=0, double val=0);
+    void skip_space();
+    bool accept(string tok);
+    void parse_expr();
+    void parse_term();
+    void parse_unary();
+    void parse_power();
+    void parse_primary();
+    int find_var(string name);
+    void fail(string msg);
+};
+
+ExprVM::ExprVM(string src, vector<string> var_names){
+    this->src = src;
+    this->var_names = var_names;
+    pos = depth = max_depth = 0;
+    parse_expr();
+    skip_space();
+    if(pos != (int)src.size())
+        fail("unexpected character");
+}
+
+void ExprVM::fail(string msg){
+    throw runtime_error("expression error at " + to_string(pos) + ": " + msg + " in \"" + src + "\"");
+}
+
+// 記錄 stack 深度, 讓 run() 事先配置好每一層的 block.
+void ExprVM::emit(OpCode op, int arg, double val){
+    if(op == OP_CONST || op == OP_VAR)
+        depth++;
+    else if(op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV || op == OP_POW)
+        depth--;
+    max_depth = max(max_depth, depth);
+    code.push_back({op, arg, val});
+}
+
+void ExprVM::skip_space(){
+    while(pos < (int)src.size() && isspace((unsigned char)src[pos]))
+        pos++;
+}
+
+bool ExprVM::accept(string tok){
+    skip_space();
+    if(src.compare(pos, tok.size(), tok) != 0)
+        return false;
+    pos += tok.size();
+    return true;
+}
+
+void ExprVM::parse_expr(){
+    parse_term();
+    while(true){
+        if(accept("+")){ parse_term(); emit(OP_ADD); }
+        else if(accept("-")){ parse_term(); emit(OP_SUB); }
+        else break;
+    }
+}
+
+void ExprVM::parse_term(){
+    parse_unary();
+    while(true){
+        if(accept("*")){ parse_unary(); emit(OP_MUL); }
+        else if(accept("/")){ parse_unary(); emit(OP_DIV); }
+        else break;
+    }
+}
+
+void ExprVM::parse_unary(){
+    if(accept("-")){
+        parse_unary();
+        emit(OP_NEG);
+    }
+    else if(accept("+"))
+        parse_unary();
+    else
+        parse_power();
+}
+
+// 次方為右結合, 且比一元負號優先: -x^2 = -(x^2).
+void ExprVM::parse_power(){
+    parse_primary();
+    if(accept("^") || accept("**")){
+        int start = code.size();
+        parse_unary();
+        // x^2 最常見, 直接換成乘法.
+        if((int)code.size() == start + 1 && code[start].op == OP_CONST && code[start].val == 2){
+            code.pop_back();
+            depth--;
+            emit(OP_SQUARE);
+        }
+        else
+            emit(OP_POW);
+    }
+}
+
+int ExprVM::find_var(string name){
+    for(int i=0;i<(int)var_names.size();i++)
+        if(var_names[i] == name)
+            return i;
+    string alias = "xyz";
+    if(name.size() == 1 && alias.find(name[0]) != string::npos && alias.find(name[0]) < var_names.size())
+        return alias.find(name[0]);
+    return -1;
+}
+
+void ExprVM::parse_primary(){
+    skip_space();
+    if(pos >= (int)src.size())
+        fail("unexpected end");
+
+    char c = src[pos];
+    if(isdigit((unsigned char)c) || c == '.'){
+        char *end;
+        double val = strtod(src.c_str() + pos, &end);
+        pos = end - src.c_str();
+        emit(OP_CONST, 0, val);
+        return;
+    }
+    if(accept("(")){
+        parse_expr();
+        if(!accept(")"))
+            fail("expected ')'");
+        return;
+    }
+    if(!isalpha((unsigned char)c))
+        fail("unexpected character");
+
+    int start = pos;
+    while(pos < (int)src.size() && (isalnum((unsigned char)src[pos]) || src[pos] == '_'))
+        pos++;
+    string name = src.substr(start, pos - start);
+
+    if(!accept("(")){
+        if(name == "pi")
+            emit(OP_CONST, 0, M_PI);
+        else if(name == "e")
+            emit(OP_CONST, 0, M_E);
+        else{
+            int idx = find_var(name);
+            if(idx < 0)
+                fail("unknown variable '" + name + "'");
+            emit(OP_VAR, idx);
+        }
+        return;
+    }
+
+    parse_expr();
+    if(name == "pow"){
+        if(!accept(","))
+            fail("pow needs two arguments");
+        parse_expr();
+        emit(OP_POW);
+    }
+    else if(name == "sin") emit(OP_SIN);
+    else if(name == "cos") emit(OP_COS);
+    else if(name == "tan") emit(OP_TAN);
+    else if(name == "exp") emit(OP_EXP);
+    else if(name == "log") emit(OP_LOG);
+    else if(name == "sqrt") emit(OP_SQRT);
+    else if(name == "abs") emit(OP_ABS);
+    else fail("unknown function '" + name + "'");
+    if(!accept(")"))
+        fail("expected ')'");
+}
+
+// 對 n 個個體計算運算式, vars[i] 指向第 i 個變數的陣列.
+// 以 BLOCK 個個體為一組, 每個 opcode 一次處理整組, stack 留在 cache 裡.
+// 每個 thread 有自己的 stack, 同一個 ExprVM 可以同時在多個 thread 使用.
+void ExprVM::run(const vector<const double*> &vars, double *out, int n){
+    thread_local vector<double> stack;
+    int stride = min(BLOCK, n);
+    if(stack.size() < (size_t)max(max_depth, 1) * stride)
+        stack.resize((size_t)max(max_depth, 1) * stride);
+    for(int base=0;base<n;base+=BLOCK){
+        int m = min(BLOCK, n - base);
+        int sp = -1;
+        for(const Instr &ins: code){
+            double *a = &stack[(size_t)max(sp, 0) * stride];
+            double *b = &stack[(size_t)(sp + 1) * stride];
+            double *c = (sp > 0) ? &stack[(size_t)(sp - 1) * stride] : a;
+            switch(ins.op){
+            case OP_CONST:
+                for(int i=0;i<m;i++) b[i] = ins.val;
+                sp++; break;
+            case OP_VAR:{
+                const double *v = vars[ins.arg] + base;
+                for(int i=0;i<m;i++) b[i] = v[i];
+                sp++; break;
+            }
+            case OP_ADD: for(int i=0;i<m;i++) c[i] += a[i]; sp--; break;
+            case OP_SUB: for(int i=0;i<m;i++) c[i] -= a[i]; sp--; break;
+            case OP_MUL: for(int i=0;i<m;i++) c[i] *= a[i]; sp--; break;
+            case OP_DIV: for(int i=0;i<m;i++) c[i] /= a[i]; sp--; break;
+            case OP_POW: for(int i=0;i<m;i++) c[i] = pow(c[i], a[i]); sp--; break;
+            case OP_NEG: for(int i=0;i<m;i++) a[i] = -a[i]; break;
+            case OP_SQUARE: for(int i=0;i<m;i++) a[i] *= a[i]; break;
+            case OP_SIN: for(int i=0;i<m;i++) a[i] = sin(a[i]); break;
+            case OP_COS: for(int i=0;i<m;i++) a[i] = cos(a[i]); break;
+            case OP_TAN: for(int i=0;i<m;i++) a[i] = tan(a[i]); break;
+            case OP_EXP: for(int i=0;i<m;i++) a[i] = exp(a[i]); break;
+            case OP_LOG: for(int i=0;i<m;i++) a[i] = log(a[i]); break;
+            case OP_SQRT: for(int i=0;i<m;i++) a[i] = sqrt(a[i]); break;
+            case OP_ABS: for(int i=0;i<m;i++) a[i] = fabs(a[i]); break;
+            }
+        }
+        for(int i=0;i<m;i++)
+            out[base + i] = stack[i];
+    }
+}
+
+double ExprVM::eval(const vector<double> &vars){
+    vector<const double*> ptrs;
+    for(const double &v: vars)
+        ptrs.push_back(&v);
+    double out;
+    run(ptrs, &out, 1);
+    return out;
+}
+
+// 單一個體, 兩個變數: 給 HillClimbing / Anneling / TabuSearch 每次算一個點的 evaluate() 用.
+// 不經過 run() 的 block 迴圈, 也不必為變數建 vector, stack 一樣是每個 thread 一份.
+double ExprVM::eval(double x1, double x2){
+    if(var_names.size() != 2)
+        throw runtime_error("eval(x1, x2) needs an expression of 2 variables");
+    thread_local vector<double> stack;
+    if(stack.size() < (size_t)max(max_depth, 1))
+        stack.resize(max(max_depth, 1));
+    double *s = stack.data();
+    int sp = -1;
+    for(const Instr &ins: code){
+        switch(ins.op){
+        case OP_CONST: s[++sp] = ins.val; break;
+        case OP_VAR: s[++sp] = (ins.arg == 0) ? x1 : x2; break;
+        case OP_ADD: s[sp - 1] += s[sp]; sp--; break;
+        case OP_SUB: s[sp - 1] -= s[sp]; sp--; break;
+        case OP_MUL: s[sp - 1] *= s[sp]; sp--; break;
+        case OP_DIV: s[sp - 1] /= s[sp]; sp--; break;
+        case OP_POW: s[sp - 1] = pow(s[sp - 1], s[sp]); sp--; break;
+        case OP_NEG: s[sp] = -s[sp]; break;
+        case OP_SQUARE: s[sp] *= s[sp]; break;
+        case OP_SIN: s[sp] = sin(s[sp]); break;
+        case OP_COS: s[sp] = cos(s[sp]); break;
+        case OP_TAN: s[sp] = tan(s[sp]); break;
+        case OP_EXP: s[sp] = exp(s[sp]); break;
+        case OP_LOG: s[sp] = log(s[sp]); break;
+        case OP_SQRT: s[sp] = sqrt(s[sp]); break;
+        case OP_ABS: s[sp] = fabs(s[sp]); break;
+        }
+    }
+    return s[0];
+}
+
+void ExprVM::print_code(){
+    const char *names[] = {"const", "var", "add", "sub", "mul", "div", "pow", "neg", "square",
+                           "sin", "cos", "tan", "exp", "log", "sqrt", "abs"};
+    for(const Instr &ins: code){
+        cout<<names[ins.op];
+        if(ins.op == OP_CONST) cout<<" "<<ins.val;
+        if(ins.op == OP_VAR) cout<<" "<<var_names[ins.arg];
+        cout<<"\n";
+    }
+}
+
+#endif
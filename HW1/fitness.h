@@ -0,0 +1,59 @@
+#ifndef FITNESS_H
+#define FITNESS_H
+#include<cmath>
+#include<string>
+#include<vector>
+#include<functional>
+#include<memory>
+#include<stdexcept>
+#include"expr_vm.h"
+using namespace std;
+
+// 批次 fitness: cols 為 dim 個 column, 第 j 個變數在 cols + j*n, 結果寫入 out.
+typedef function<void(const double *cols, int n, int dim, double *out)> BatchKernel;
+
+// HW1 的 fitness: (x1^2 + x2^2)^0.25 * (sin^2(50 (x1^2 + x2^2)^0.1) + 1).
+void hw1_fitness(const double *cols, int n, int dim, double *out){
+    if(dim != 2)
+        throw runtime_error("hw1 fitness needs 2 variables, got " + to_string(dim));
+    for(int i=0;i<n;i++){
+        double x1=cols[i], x2=cols[n + i];
+        double left_part = pow(x1*x1 + x2*x2, 0.25),
+                right_part = pow(sin(50*pow((x1*x1 + x2*x2), 0.1)), 2.0) + 1;
+        out[i] = left_part * right_part;
+    }
+}
+
+// HW2 Q1 的 fitness: 80 - x^2 - y^2 + 10 cos(2 pi x) + 10 cos(2 pi y).
+void q1_fitness(const double *cols, int n, int dim, double *out){
+    if(dim != 2)
+        throw runtime_error("q1 fitness needs 2 variables, got " + to_string(dim));
+    for(int i=0;i<n;i++){
+        double x=cols[i], y=cols[n + i];
+        out[i] = 80 - x*x - y*y + 10*cos(2*M_PI*x) + 10*cos(2*M_PI*y);
+    }
+}
+
+// 以名稱取得註冊的 fitness, 其他字串當成 ExprVM 的運算式 (變數 x1 ... x<dim>).
+// hw1 / q1 只有兩個變數, dim 不是 2 時丟出例外.
+BatchKernel find_fitness(string name, int dim){
+    if((name == "hw1" || name == "q1") && dim != 2)
+        throw runtime_error(name + " fitness needs 2 variables, got " + to_string(dim));
+    if(name == "hw1")
+        return hw1_fitness;
+    if(name == "q1")
+        return q1_fitness;
+    vector<string> vars;
+    for(int j=1;j<=dim;j++)
+        vars.push_back("x" + to_string(j));
+    // kernel 被複製時共用同一個 VM, 最後一份 kernel 消失時釋放.
+    shared_ptr<ExprVM> vm = make_shared<ExprVM>(name, vars);
+    return [vm](const double *cols, int n, int dim, double *out){
+        vector<const double*> ptrs;
+        for(int j=0;j<dim;j++)
+            ptrs.push_back(cols + (size_t)j * n);
+        vm->run(ptrs, out, n);
+    };
+}
+
+#endif
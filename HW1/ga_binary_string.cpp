@@ -5,65 +5,134 @@
 #include<vector>
 #include<climits>
 #include"ga_util.h"
+#include"expr_vm.h"
+#include"elite_archive.h"
+#include"rate_control.h"
+#include"anytime.h"
+#include"low_discrepancy.h"
 using namespace std;
 
+// 第 i 個 gene 為 word 的 bit i, 每個變數最多 64 個 gene.
 struct cell{
-    vector<int> x1, x2;
+    unsigned long long x1, x2;
     double fitness;
 };
 
+// 在 [min_bound, max_bound] 中達到 precision 需要的 bit 數, 可以在編譯時計算:
+//   constexpr int HW1_BITS = gene_bits(0, 1, 0.0001);  // 14
+constexpr int gene_bits(double min_bound, double max_bound, double precision){
+    int n_bit = 1;
+    while(n_bit < 64 && precision < (max_bound - min_bound) / ((double)(1ULL << n_bit) - 1))
+        n_bit++;
+    return n_bit;
+}
+
+// byte 的 gray code -> binary 對照表, 由 build_gray_table() 建立.
+unsigned char gray_table[256];
+
+void build_gray_table(){
+    for(int v=0;v<256;v++){
+        int b = v;
+        b ^= b >> 1;
+        b ^= b >> 2;
+        b ^= b >> 4;
+        gray_table[v] = b;
+    }
+}
+
+// Decode a gray coded word one byte at a time, starting from the most
+// significant byte. The parity of all higher bits is carried into the
+// next byte, so a set carry simply flips the whole byte.
+unsigned long long gray_decode(unsigned long long gray, int n_bit){
+    unsigned long long bin = 0;
+    int carry = 0;
+    for(int shift=(n_bit-1)/8*8;shift>=0;shift-=8){
+        unsigned char byte = gray_table[(gray >> shift) & 0xFF] ^ (carry ? 0xFF : 0);
+        bin |= (unsigned long long)byte << shift;
+        carry = byte & 1;
+    }
+    return bin;
+}
+
+// N > 0 時 gene 長度在編譯時決定, decode / crossover / mutation 的迴圈長度都是常數;
+// N = 0 時長度由 precision 在執行時決定.
+template<int N>
 class GABinaryString{
 public:
+    static_assert(N >= 0 && N <= 64, "genes must fit in a 64-bit word");
     int max_iter, population_size, gene_len;
-    float interval, p_mutation, p_crossover;
+    float min_bound, interval, p_mutation, p_crossover;
+    string encoding;    // "binary" or "gray".
+    bool gray;
+    unsigned long long gene_mask;   // 最低 gene_len 個 bit 為 1.
+    ExprVM *fitness_expr = NULL;    // 不為 NULL 時以運算式取代內建的 fitness.
+    vector<double> col_x1, col_x2, col_fitness;
     vector<cell> population;   // The total number of population.
     vector<cell> pool;
     vector<int> best_gene_list;
     cell best_cell;
     int best_iter, cur_iter=0;
-    GABinaryString(int max_iter, int population_size, int min_bound, int max_bound, float precision, float p_mutation, float p_crossover);
+    int elite_size = 0;         // > 0 時保留 elite_size 個 elite, 每個 generation 放回 population.
+    EliteArchive<cell> archive;
+    vector<char> changed;       // 這個 generation 被 crossover/mutation 改過的個體.
+    vector<int> changed_list;   // changed 為 1 的位置, update_archive 只走過這些.
+    vector<int> elite_slots;    // 這個 generation 放回 elite 的位置.
+    RateController *rate_control = NULL;    // 不為 NULL 時依 operator 的成功率調整 p_crossover / p_mutation.
+    AnytimeTrace *trace = NULL;     // 不為 NULL 時記錄 best-so-far, 每個 generation 算 population_size 次.
+    Sampler *sampler = NULL;        // 不為 NULL 時 initialize() 的 gene 由 scrambled 點集量化而來.
+    GABinaryString(int max_iter, int population_size, float min_bound, float max_bound, float precision, float p_mutation, float p_crossover, string encoding="binary");
+    int bits();
     void initialize();
     void evaluate();
-    double cal_decimal(vector<int> x);
+    double cal_decimal(unsigned long long x);
     void crossover();
     void mutation();
     void select(string mode, int times);
     void run(string mode, int times);
     int find_best(string mode);
+    int update_archive();
+    void mark_changed(int k);
     void print_info(int iter_interval);
     void print_gene(int idx);
 };
 
-void GABinaryString::print_gene(int idx){
+template<int N>
+void GABinaryString<N>::print_gene(int idx){
     cout<<"\npopulation x1: ";
-    for (int i = 0; i < gene_len; i++)
-        cout<<population[idx].x1[i];
+    for (int i = 0; i < bits(); i++)
+        cout<<(population[idx].x1 >> i & 1);
     cout<<", "<<cal_decimal(population[idx].x1);
     cout<<"\npopulation x2: ";
-    for (int i = 0; i < gene_len; i++)
-        cout<<population[idx].x2[i];
+    for (int i = 0; i < bits(); i++)
+        cout<<(population[idx].x2 >> i & 1);
 
     cout<<"\npool x1: ";
-    for (int i = 0; i < gene_len; i++)
-        cout<<pool[idx].x1[i];
+    for (int i = 0; i < bits(); i++)
+        cout<<(pool[idx].x1 >> i & 1);
     cout<<"\npool x2: ";
-    for (int i = 0; i < gene_len; i++)
-        cout<<pool[idx].x2[i];
+    for (int i = 0; i < bits(); i++)
+        cout<<(pool[idx].x2 >> i & 1);
 }
 
-GABinaryString::GABinaryString(int max_iter, int population_size, int min_bound, int max_bound, float precision, float p_mutation, float p_crossover){
+template<int N>
+GABinaryString<N>::GABinaryString(int max_iter, int population_size, float min_bound, float max_bound, float precision, float p_mutation, float p_crossover, string encoding){
 
     this->max_iter = max_iter;
     this->population_size = population_size;
     this->p_mutation = p_mutation;
     this->p_crossover = p_crossover;
+    this->min_bound = min_bound;
+    this->encoding = encoding;
+    this->gray = (encoding == "gray");
+    if(gray)
+        build_gray_table();
 
-    int n_bit = 1;
-    float range = max_bound - min_bound;
-    while(precision < (max_bound - min_bound) / (pow(2, n_bit) - 1))
-        n_bit++;
+    int n_bit = gene_bits(min_bound, max_bound, precision);
+    if(N > 0 && n_bit != N)
+        throw runtime_error("precision needs " + to_string(n_bit) + " bits, not " + to_string(N));
 
     this->gene_len = n_bit;
+    this->gene_mask = (n_bit == 64) ? ~0ULL : (1ULL << n_bit) - 1;
     this->interval = (max_bound - min_bound) / pow(2, gene_len);
 
     cout<<"nbits: "<<n_bit<<endl;
@@ -72,18 +141,57 @@ GABinaryString::GABinaryString(int max_iter, int population_size, int min_bound,
     cout<<"Constructor.\n";
 }
 
-void GABinaryString::initialize(){
+// 編譯時已知的長度讓下面的迴圈都是固定次數.
+template<int N>
+int GABinaryString<N>::bits(){
+    return (N > 0) ? N : gene_len;
+}
+
+template<int N>
+void GABinaryString<N>::initialize(){
+    if(sampler != NULL){
+        // [0, 1) 的點量化成 bits() 個 bit, 之後與 cal_decimal 相同方向解碼.
+        vector<double> cols(2 * population_size);
+        sampler->restart();
+        sampler->next(population_size, cols.data());
+        for(int i=0;i<population_size;i++){
+            cell node = {0, 0, 0};
+            unsigned long long *genes[2] = {&node.x1, &node.x2};
+            for(int j=0;j<2;j++){
+                unsigned long long v = min((unsigned long long)ldexp(cols[j * population_size + i], bits()), gene_mask);
+                *genes[j] = gray ? v ^ (v >> 1) : v;
+            }
+            population.push_back(node);
+        }
+        return;
+    }
     for(int i=0;i<population_size;i++){
-        cell node;
-        for(int j=0;j<gene_len;j++){
-            node.x1.push_back(rand() & 1);
-            node.x2.push_back(rand() & 1);
+        cell node = {0, 0, 0};
+        for(int j=0;j<bits();j++){
+            node.x1 |= (unsigned long long)(rand() & 1) << j;
+            node.x2 |= (unsigned long long)(rand() & 1) << j;
         }
         population.push_back(node);
     }
 }
 
-void GABinaryString::evaluate(){
+template<int N>
+void GABinaryString<N>::evaluate(){
+    if(fitness_expr != NULL){
+        // 先解碼成 column 再交給 VM 一次算完整個 population.
+        int n = population.size();
+        col_x1.resize(n);
+        col_x2.resize(n);
+        col_fitness.resize(n);
+        for(int i=0;i<n;i++){
+            col_x1[i] = cal_decimal(population[i].x1);
+            col_x2[i] = cal_decimal(population[i].x2);
+        }
+        fitness_expr->run({col_x1.data(), col_x2.data()}, col_fitness.data(), n);
+        for(int i=0;i<n;i++)
+            population[i].fitness = col_fitness[i];
+        return;
+    }
     for(auto& node: population){
         double x1 = cal_decimal(node.x1),
             x2 = cal_decimal(node.x2);
@@ -95,15 +203,15 @@ void GABinaryString::evaluate(){
     }
 }
 
-double GABinaryString::cal_decimal(vector<int> x){
-    double dec_val = 0;
-    for(int i=0;i<gene_len;i++)
-        dec_val += x[i] * (0b1 << i);
-
-    return dec_val * interval;
+template<int N>
+double GABinaryString<N>::cal_decimal(unsigned long long x){
+    if(gray)
+        x = gray_decode(x, bits());
+    return min_bound + x * interval;
 }
 
-void GABinaryString::select(string mode, int times){
+template<int N>
+void GABinaryString<N>::select(string mode, int times){
     pool.clear();
     for(int i=0;i<population_size;i++){
         int select_idx = rand() % population_size;
@@ -120,26 +228,53 @@ void GABinaryString::select(string mode, int times){
         }
         pool.push_back(population[select_idx]);
     }
+    // Elitism: 把 archive 裡的 elite 放回隨機的位置.
+    elite_slots.clear();
+    if(elite_size > 0){
+        for(const cell &elite: archive.heap){
+            int idx = rand() % population_size;
+            pool[idx] = elite;
+            elite_slots.push_back(idx);
+        }
+    }
     population.clear();
     population.assign(pool.begin(), pool.end());
+    changed.assign(population_size, 0);
+    changed_list.clear();
+    if(rate_control != NULL)
+        rate_control->begin_generation(population);
 
 }
 
-void GABinaryString::mutation(){
-    for(auto& node: population){
-        for(int i=0;i<gene_len;i++){
-            if((double)rand() / RAND_MAX < p_mutation)
-                node.x1[i] = rand() & 1;
-            if((double)rand() / RAND_MAX < p_mutation)
-                node.x2[i] = rand() & 1;
+template<int N>
+void GABinaryString<N>::mutation(){
+    for(int k=0;k<population_size;k++){
+        cell &node = population[k];
+        bool mutated = false;
+        for(int i=0;i<bits();i++){
+            unsigned long long bit = 1ULL << i;
+            if((double)rand() / RAND_MAX < p_mutation){
+                node.x1 = (node.x1 & ~bit) | ((unsigned long long)(rand() & 1) << i);
+                mutated = true;
+            }
+            if((double)rand() / RAND_MAX < p_mutation){
+                node.x2 = (node.x2 & ~bit) | ((unsigned long long)(rand() & 1) << i);
+                mutated = true;
+            }
+        }
+        if(mutated){
+            mark_changed(k);
+            if(rate_control != NULL)
+                rate_control->mark(k, RateController::MUTATION);
         }
     }
 }
 
-void GABinaryString::crossover(){
+template<int N>
+void GABinaryString<N>::crossover(){
     int idx1, idx2;
     int pos;    // Crossover position.
-    int min_pos=1, max_pos=gene_len-1;
+    int min_pos=1, max_pos=bits()-1;
     for(int i=0;i<population_size;i++){
         if((double)rand() / RAND_MAX > p_crossover)  // Do not corssover.
             continue;
@@ -152,28 +287,50 @@ void GABinaryString::crossover(){
         // Determine the position of exchange.
         pos = rand() % (max_pos - min_pos + 1) + min_pos;
 
-        // Start to exchange.
-        for(int j=pos;j<gene_len;j++){
-            population[idx1].x1[j] = pool[idx2].x1[j];
-            population[idx2].x1[j] = pool[idx1].x1[j];
-            population[idx1].x2[j] = pool[idx2].x2[j];
-            population[idx2].x2[j] = pool[idx1].x2[j];
+        // Start to exchange: 第 pos 個之後的 gene 一次以 mask 交換.
+        unsigned long long tail = gene_mask & ~((1ULL << pos) - 1);
+        population[idx1].x1 = (population[idx1].x1 & ~tail) | (pool[idx2].x1 & tail);
+        population[idx2].x1 = (population[idx2].x1 & ~tail) | (pool[idx1].x1 & tail);
+        population[idx1].x2 = (population[idx1].x2 & ~tail) | (pool[idx2].x2 & tail);
+        population[idx2].x2 = (population[idx2].x2 & ~tail) | (pool[idx1].x2 & tail);
+        mark_changed(idx1);
+        mark_changed(idx2);
+        if(rate_control != NULL){
+            rate_control->mark(idx1, RateController::CROSSOVER);
+            rate_control->mark(idx2, RateController::CROSSOVER);
         }
 
     }
 }
 
-void GABinaryString::run(string mode, int times){
+template<int N>
+void GABinaryString<N>::run(string mode, int times){
     best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
     initialize();
     evaluate();
+    if(trace != NULL)
+        trace->record(population);
+    changed.assign(population_size, 1);
+    changed_list.resize(population_size);
+    for(int i=0;i<population_size;i++)
+        changed_list[i] = i;
+    if(elite_size > 0){
+        archive = EliteArchive<cell>(elite_size, mode, [](const cell &node){
+            return hash<unsigned long long>()(node.x1) * 31 + hash<unsigned long long>()(node.x2);
+        });
+        update_archive();
+    }
     for(int iter=0;iter<max_iter;iter++){
         select(mode, times);
         crossover();
         mutation();
         evaluate();
 
-        int best_idx = find_best(mode);
+        if(trace != NULL)
+            trace->record(population);
+        if(rate_control != NULL)
+            rate_control->end_generation(population, mode, iter, p_crossover, p_mutation);
+        int best_idx = (elite_size > 0) ? update_archive() : find_best(mode);
         best_gene_list.push_back(best_idx);
 
     }
@@ -181,7 +338,39 @@ void GABinaryString::run(string mode, int times){
     print_info(iter_interval);
 }
 
-int GABinaryString::find_best(string mode){
+template<int N>
+void GABinaryString<N>::mark_changed(int k){
+    if(!changed[k]){
+        changed[k] = 1;
+        changed_list.push_back(k);
+    }
+}
+
+// find_best 的 incremental 版本: 只把這個 generation 改過的個體交給 archive,
+// best_cell 取自 archive. 回傳的 index 只在改過的個體與 elite 的位置中挑選,
+// 所以每個 generation 的成本與改過的個體數成正比, 不必掃過整個 population.
+template<int N>
+int GABinaryString<N>::update_archive(){
+    cur_iter++;
+    int idx = elite_slots.empty() ? 0 : elite_slots[0];
+    for(int i: changed_list){
+        archive.offer(population[i]);
+        if(archive.better(population[i], population[idx]))
+            idx = i;
+    }
+    for(int slot: elite_slots)
+        if(archive.better(population[slot], population[idx]))
+            idx = slot;
+
+    if(archive.better(archive.best_cell, best_cell)){
+        best_cell = archive.best_cell;
+        best_iter = cur_iter;
+    }
+    return idx;
+}
+
+template<int N>
+int GABinaryString<N>::find_best(string mode){
     cur_iter++;
     int idx;
     if(mode == "max"){
@@ -213,7 +402,8 @@ int GABinaryString::find_best(string mode){
     return idx;
 }
 
-void GABinaryString::print_info(int iter_interval){
+template<int N>
+void GABinaryString<N>::print_info(int iter_interval){
     int iter = 1;
     iter_interval=1;
     for(int iter=0;iter<best_gene_list.size();iter+=iter_interval){
@@ -236,51 +426,91 @@ void GABinaryString::print_info(int iter_interval){
 
 }
 
-int main(){
-    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
-
-    int max_iter=10000, population_size=50, min_bound=0, max_bound=1;
-    float precision=0.0001, p_mutation=0.01, p_crossover=0.25;
+#ifndef GA_NO_MAIN    // pyga.cpp 等其他程式 include 這個檔案時不需要 main.
+template<int N>
+void run_trials(float min_bound, float max_bound, float precision, ExprVM *fitness_expr, Sampler *sampler){
+    int max_iter=10000, population_size=50;
+    float p_mutation=0.01, p_crossover=0.25;
 
-    string mode = "max";
+    string mode = "max", encoding = "gray";
     int times = 5;
+    int elite_size = 2;
     // 收集實驗數據用於計算平均和最大最小值範圍
-    vector<float> total_fitness, total_iter, total_x1, total_x2;
+    StreamStats total_fitness, total_iter, total_x1, total_x2;
     // 收集數據之實驗次數
     int exp_num=10;
     for(int exp=0;exp<exp_num;exp++){
-        GABinaryString ga(
+        GABinaryString<N> ga(
         max_iter,
         population_size,
         min_bound,
         max_bound,
         precision,
         p_mutation,
-        p_crossover);
+        p_crossover,
+        encoding);
+        ga.fitness_expr = fitness_expr;
+        ga.elite_size = elite_size;
+        ga.sampler = sampler;
 
         ga.run(mode, times);
 
-        total_fitness.push_back(ga.best_cell.fitness);
-        total_x1.push_back(ga.cal_decimal(ga.best_cell.x1));
-        total_x2.push_back(ga.cal_decimal(ga.best_cell.x2));
-        total_iter.push_back(ga.best_iter);
+        total_fitness.add(ga.best_cell.fitness);
+        total_x1.add(ga.cal_decimal(ga.best_cell.x1));
+        total_x2.add(ga.cal_decimal(ga.best_cell.x2));
+        total_iter.add(ga.best_iter);
 
     }
 
     cout<<"===\n";
     cout<<"|name|stats|\n";
     cout<<"|-|-|\n";
-    cout<<"|fitness mean| "<<setprecision(6)<<find_sum(total_fitness)/ exp_num<<"|\n";
-    cout<<"|iter mean   | "<<find_sum(total_iter) / exp_num<<"|\n";
-    cout<<"|x1 mean     | "<<setprecision(4)<<find_sum(total_x1) / exp_num<<"|\n";
-    cout<<"|x2 mean     | "<<setprecision(4)<<find_sum(total_x2) / exp_num<<"|\n";
+    cout<<"|fitness mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+    cout<<"|iter mean   | "<<total_iter.mean<<"|\n";
+    cout<<"|x1 mean     | "<<setprecision(4)<<total_x1.mean<<"|\n";
+    cout<<"|x2 mean     | "<<setprecision(4)<<total_x2.mean<<"|\n";
 
     find_range(total_fitness, "fitness");
+    find_ci(total_fitness, "fitness");
     find_range(total_iter, "iter");
     find_range(total_x1, "x1");
     find_range(total_x2, "x2");
 
     cout<<"\n Now mode: "<<mode<<endl;
-    cout<<"GA binary string\n";
+    cout<<"GA binary string ("<<encoding<<", "<<((N > 0) ? to_string(N) + " bits" : "runtime length")<<")\n";
+}
+
+// ./ga_binary_string.out [--sampler sobol|halton|lhs] ["fitness expression" [min_bound max_bound]]
+int main(int argc, char *argv[]){
+    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
 
+    float min_bound=0, max_bound=1;
+    float precision=0.0001;
+
+    string sampler_kind;
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--sampler" && i + 1 < argc)
+            sampler_kind = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+    Sampler *sampler = sampler_kind.empty() ? NULL : new Sampler(sampler_kind, 2, rand());
+
+    // 常用的長度有各自的 specialization, 其他長度用 runtime 版本.
+    switch(gene_bits(min_bound, max_bound, precision)){
+        case 14: run_trials<14>(min_bound, max_bound, precision, fitness_expr, sampler); break;
+        case 16: run_trials<16>(min_bound, max_bound, precision, fitness_expr, sampler); break;
+        case 32: run_trials<32>(min_bound, max_bound, precision, fitness_expr, sampler); break;
+        default: run_trials<0>(min_bound, max_bound, precision, fitness_expr, sampler); break;
+    }
 }
+#endif
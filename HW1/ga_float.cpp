@@ -5,6 +5,22 @@
 #include<vector>
 #include<climits>
 #include"ga_util.h"
+#include"expr_vm.h"
+#include"dist_eval.h"
+#include"parallel.h"
+#include"elite_archive.h"
+#include"rate_control.h"
+#include"anytime.h"
+#include"surrogate.h"
+#include"peak_finder.h"
+#include"local_search.h"
+#include"low_discrepancy.h"
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<random>
+#include<cfloat>
+#include<set>
 using namespace std;
 
 struct cell{
@@ -15,27 +31,73 @@ struct cell{
 class GAFloat{
 public:
     int max_iter, population_size;
-    float p_mutation, p_crossover;
+    float min_bound, max_bound, precision, p_mutation, p_crossover;
+    ExprVM *fitness_expr = NULL;    // 不為 NULL 時以運算式取代內建的 fitness.
+    DistEvaluator *dist = NULL;     // 不為 NULL 時把 evaluate 分給 worker process.
+    int batch_size = 256;           // 每次送給 worker 的個體數.
+    vector<double> col_x1, col_x2, col_fitness, send_buf;
     vector<cell> population;   // The total number of population.
     vector<cell> pool;
     vector<int> best_gene_list;
     cell best_cell;
     int best_iter, cur_iter=0;
+    int elite_size = 0;         // > 0 時保留 elite_size 個 elite, 每個 generation 放回 population.
+    EliteArchive<cell> archive;
+    vector<char> changed;       // 這個 generation 被 crossover/mutation 改過的個體.
+    vector<int> changed_list;   // changed 為 1 的位置, update_archive 只走過這些.
+    vector<int> elite_slots;    // 這個 generation 放回 elite 的位置.
+    RateController *rate_control = NULL;    // 不為 NULL 時依 operator 的成功率調整 p_crossover / p_mutation.
+    AnytimeTrace *trace = NULL;     // 不為 NULL 時記錄 best-so-far, 每個 generation 算 population_size 次.
+    KnnSurrogate *surrogate = NULL; // 不為 NULL 時先用 surrogate 篩選 offspring.
+    float surrogate_ratio = 0.3;    // 真正計算 fitness 的 offspring 比例.
+    long n_real_evals = 0, n_saved_evals = 0;
+    bool two_tier = false;          // 先用 float 算全部, 只有可能影響結果的個體再用 double 重算.
+    double tolerance = 1e-4;        // tournament 比較容許的 fitness 誤差.
+    double error_scale = 1;         // float 誤差估計的安全係數.
+    double max_error_ratio = 0;     // 重算時實際誤差 / 誤差上限 的最大值.
+    vector<double> err;             // evaluate_two_tier 中每個個體 float 值的誤差上限.
+    long n_screened = 0, n_refined = 0, n_reused = 0;
+    double utilization = 0;     // run_steady_state 中 worker 在計算 fitness 的時間比例.
+    int tile_size = 256;        // run_tiled 每個 tile 的個體數: 兩份 cell (24B), column 與 offspring 共約 19KB, 放得進 32KB 的 L1d.
+    vector<cell> tile_parents;
+    float memetic_ratio = 0;    // > 0 時每 memetic_interval 個 generation 對最好的 memetic_ratio 比例做 local search.
+    int memetic_interval = 10;
+    long local_budget = 300;    // 每個個體 local search 最多的 evaluation 數.
+    float local_step = 0.01;    // 起始的鄰域大小, 與 HillClimbing 的 precision 相同.
+    int local_threads = default_threads();
+    long n_local_evals = 0;     // local search 用掉的 evaluation, 不算在 max_iter * population_size 內.
+    Sampler *sampler = NULL;    // 不為 NULL 時 initialize() 以一組新的 scrambled 點集取代 rand().
     GAFloat(int max_iter, int population_size, float min_bound, float max_bound, float precision, float p_mutation, float p_crossover);
     void initialize();
     void evaluate();
     void crossover();
     void mutation();
+    void mutation(int begin, int end);
+    void submit_batches(int begin, int end);
+    void collect();
+    void evaluate_screened(string mode);
+    void evaluate_two_tier(string mode);
+    BatchKernel kernel();
     void select(string mode, int times);
     void run(string mode, int times);
+    void run_steady_state(string mode, int times, int n_threads);
+    void run_tiled(string mode, int times);
+    void local_search(string mode);
     int find_best(string mode);
+    void mark_changed(int k);
+    void mark_all_changed();
+    int update_archive();
     void print_info(int iter_interval);
+    double randfloat(float min, float max);
 };
 
 GAFloat::GAFloat(int max_iter, int population_size, float min_bound, float max_bound, float precision, float p_mutation, float p_crossover){
 
     this->max_iter = max_iter;
     this->population_size = population_size;
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    this->precision = precision;
     this->p_mutation = p_mutation;
     this->p_crossover = p_crossover;
 
@@ -45,16 +107,49 @@ GAFloat::GAFloat(int max_iter, int population_size, float min_bound, float max_b
     cout<<"Constructor.\n";
 }
 
+double GAFloat::randfloat(float min, float max){
+    return (max - min) * rand() / RAND_MAX + min;
+}
+
 void GAFloat::initialize(){
+    if(sampler != NULL){
+        vector<double> cols(2 * population_size);
+        sampler->restart();
+        sampler->next(population_size, cols.data(), min_bound, max_bound);
+        for(int i=0;i<population_size;i++)
+            population.push_back({cols[i], cols[population_size + i], 0});
+        return;
+    }
     for(int i=0;i<population_size;i++){
         cell node;
-        node.x1 = (double)rand() / RAND_MAX;
-        node.x2 = (double)rand() / RAND_MAX;
+        node.x1 = randfloat(min_bound, max_bound);
+        node.x2 = randfloat(min_bound, max_bound);
         population.push_back(node);
     }
 }
 
 void GAFloat::evaluate(){
+    if(dist != NULL){
+        col_fitness.resize(population.size());
+        submit_batches(0, population.size());
+        collect();
+        return;
+    }
+    if(fitness_expr != NULL){
+        // 轉成 column 給 VM 一次算完整個 population.
+        int n = population.size();
+        col_x1.resize(n);
+        col_x2.resize(n);
+        col_fitness.resize(n);
+        for(int i=0;i<n;i++){
+            col_x1[i] = population[i].x1;
+            col_x2[i] = population[i].x2;
+        }
+        fitness_expr->run({col_x1.data(), col_x2.data()}, col_fitness.data(), n);
+        for(int i=0;i<n;i++)
+            population[i].fitness = col_fitness[i];
+        return;
+    }
     for(auto& node: population){
         double x1=node.x1, x2=node.x2;
         double left_part = pow(x1*x1 + x2*x2, 0.25),
@@ -64,6 +159,142 @@ void GAFloat::evaluate(){
     }
 }
 
+// 兩階段精度: 沒被 crossover/mutation 改過的個體 fitness 不變, 不需重算.
+// population 收斂後, crossover 換進來的 gene 常常與原本的相同, 這些個體與 pool 中的
+// parent 完全一樣, 直接沿用 parent 的 fitness (否則它們都在 best 附近, 全部會被條件 2 重算).
+// 其餘的先以 float 計算, 並依 forward error analysis
+// 估計每個值的誤差上限 err (sin 的參數約為 50, 其誤差經 cos 放大, 所以
+// 在 sin = ±1 的山峰附近誤差最小; 實測的誤差不到估計值的一半, 所以 error_scale 從 1 開始).
+// 只有下列個體以 double 重算:
+//   1. 2 * err > tolerance, 否則兩個 float 值的比較錯誤不會超過 tolerance;
+//   2. f 加上誤差後可能超過目前為止最好的個體, 所以 best_cell 一定是 double 的值.
+// 重算時比較實際誤差與估計值, 超過就放大 error_scale, 確保之後的判斷仍然成立.
+void GAFloat::evaluate_two_tier(string mode){
+    const double u = FLT_EPSILON / 2;  // float 一次運算的相對誤差.
+    int n = population.size();
+    col_fitness.resize(n);
+    err.resize(n);
+    double sign = (mode == "max") ? 1 : -1;     // sign * f 越大越好.
+    vector<int> offspring;
+    for(int i: changed_list){
+        cell &node = population[i];
+        if(node.x1 == pool[i].x1 && node.x2 == pool[i].x2){
+            node.fitness = pool[i].fitness;
+            n_reused++;
+            continue;
+        }
+        offspring.push_back(i);
+        float x1 = population[i].x1, x2 = population[i].x2;
+        float r2 = x1*x1 + x2*x2;
+        float arg = 50*powf(r2, 0.1f);
+        float s = sinf(arg), c = cosf(arg);
+        float right = s*s + 1;
+        float f = powf(r2, 0.25f) * right;
+        double d_arg = 4 * u * arg,
+                d_s = (fabs(c) + d_arg) * d_arg + 2 * u,
+                d_right = 2 * fabs(s) * d_s + d_s * d_s + 2 * u * right;
+        col_fitness[i] = f;
+        err[i] = error_scale * fabs(f) * (5 * u + d_right / right) + FLT_MIN;
+    }
+    double threshold = sign * best_cell.fitness;
+
+    for(int i: offspring){
+        cell &node = population[i];
+        if(2 * err[i] <= tolerance && sign * col_fitness[i] + err[i] < threshold){
+            node.fitness = col_fitness[i];
+            n_screened++;
+            continue;
+        }
+        double x1=node.x1, x2=node.x2;
+        double left_part = pow(x1*x1 + x2*x2, 0.25),
+                right_part = pow(sin(50*pow((x1*x1 + x2*x2), 0.1)), 2.0) + 1;
+        node.fitness = left_part * right_part;
+        n_refined++;
+
+        double ratio = fabs(col_fitness[i] - node.fitness) / err[i];
+        max_error_ratio = max(max_error_ratio, ratio);
+        if(ratio > 1)
+            error_scale *= 2 * ratio;
+    }
+}
+
+// 給 worker process 用的 batch fitness, 與 evaluate() 的計算相同.
+BatchKernel GAFloat::kernel(){
+    return [this](const double *cols, int n, int dim, double *out){
+        if(fitness_expr != NULL){
+            fitness_expr->run({cols, cols + n}, out, n);
+            return;
+        }
+        hw1_fitness(cols, n, dim, out);
+    };
+}
+
+// 把 population[begin, end) 切成 batch 送出, 不等結果.
+// col_fitness 必須已經配置好, 結果會直接寫進去.
+void GAFloat::submit_batches(int begin, int end){
+    for(int b=begin;b<end;b+=batch_size){
+        int m = min(batch_size, end - b);
+        send_buf.resize(2 * m);
+        for(int i=0;i<m;i++){
+            send_buf[i] = population[b + i].x1;
+            send_buf[m + i] = population[b + i].x2;
+        }
+        dist->submit(send_buf.data(), m, 2, &col_fitness[b]);
+    }
+}
+
+void GAFloat::collect(){
+    dist->wait_all();
+    for(int i=0;i<(int)population.size();i++)
+        population[i].fitness = col_fitness[i];
+}
+
+// Surrogate 篩選: 只有改過的個體需要重算. 依 surrogate 的預測排序後,
+// 前 surrogate_ratio 的 offspring 真正計算 fitness 並加入 surrogate,
+// 其餘的 offspring 丟掉, 換回 pool 裡的 parent (fitness 已知).
+// 因此 population 中的 fitness 永遠是真正算出來的值.
+void GAFloat::evaluate_screened(string mode){
+    vector<int> offspring = changed_list;
+
+    // 樣本不夠時 surrogate 還不可靠, 全部真正計算.
+    int n_real = offspring.size();
+    if(surrogate->size() >= 2 * population_size){
+        vector<pair<double, int>> ranked;
+        for(int i: offspring){
+            double pred = surrogate->predict(population[i].x1, population[i].x2);
+            ranked.push_back({(mode == "max") ? -pred : pred, i});
+        }
+        sort(ranked.begin(), ranked.end());
+        n_real = ceil(surrogate_ratio * offspring.size());
+        for(int j=0;j<(int)ranked.size();j++)
+            offspring[j] = ranked[j].second;
+        for(int j=n_real;j<(int)offspring.size();j++)
+            population[offspring[j]] = pool[offspring[j]];
+        // 只有真正計算的 offspring 還算是改過的.
+        for(int i: offspring)
+            changed[i] = 0;
+        changed_list.clear();
+        for(int j=0;j<n_real;j++)
+            mark_changed(offspring[j]);
+        n_saved_evals += offspring.size() - n_real;
+    }
+
+    BatchKernel fitness = kernel();
+    send_buf.resize(2 * n_real);
+    col_fitness.resize(n_real);
+    for(int j=0;j<n_real;j++){
+        send_buf[j] = population[offspring[j]].x1;
+        send_buf[n_real + j] = population[offspring[j]].x2;
+    }
+    fitness(send_buf.data(), n_real, 2, col_fitness.data());
+    for(int j=0;j<n_real;j++){
+        cell &node = population[offspring[j]];
+        node.fitness = col_fitness[j];
+        surrogate->add(node.x1, node.x2, node.fitness);
+    }
+    n_real_evals += n_real;
+}
+
 void GAFloat::select(string mode, int times){
     pool.clear();
     for(int i=0;i<population_size;i++){
@@ -81,8 +312,21 @@ void GAFloat::select(string mode, int times){
         }
         pool.push_back(population[select_idx]);
     }
+    // Elitism: 把 archive 裡的 elite 放回隨機的位置.
+    elite_slots.clear();
+    if(elite_size > 0){
+        for(const cell &elite: archive.heap){
+            int idx = rand() % population_size;
+            pool[idx] = elite;
+            elite_slots.push_back(idx);
+        }
+    }
     population.clear();
     population.assign(pool.begin(), pool.end());
+    changed.assign(population_size, 0);
+    changed_list.clear();
+    if(rate_control != NULL)
+        rate_control->begin_generation(population);
 }
 
 void GAFloat::crossover(){
@@ -90,23 +334,44 @@ void GAFloat::crossover(){
     for(int i=0;i<population_size;i++){
         if((double)rand() / RAND_MAX > p_crossover)  // Do not corssover.
             continue;
-            idx1 = rand() % population_size;
+        idx1 = rand() % population_size;
+        idx2 = rand() % population_size;
+        while(idx2 == idx1){
             idx2 = rand() % population_size;
-            while(idx2 == idx1){
-                idx2 = rand() % population_size;
+        }
 
-            population[idx1].x2 = pool[idx2].x2;
-            population[idx2].x1 = pool[idx1].x1;
+        population[idx1].x2 = pool[idx2].x2;
+        population[idx2].x1 = pool[idx1].x1;
+        mark_changed(idx1);
+        mark_changed(idx2);
+        if(rate_control != NULL){
+            rate_control->mark(idx1, RateController::CROSSOVER);
+            rate_control->mark(idx2, RateController::CROSSOVER);
         }
     }
 }
 
 void GAFloat::mutation(){
-    for(auto& node: population){
-        if((double)rand() / RAND_MAX < p_mutation)
-            node.x1 = rand() / RAND_MAX;
-        if((double)rand() / RAND_MAX < p_mutation)
-            node.x2 = rand() / RAND_MAX;
+    mutation(0, population.size());
+}
+
+void GAFloat::mutation(int begin, int end){
+    for(int i=begin;i<end;i++){
+        cell &node = population[i];
+        bool mutated = false;
+        if((double)rand() / RAND_MAX < p_mutation){
+            node.x1 = randfloat(min_bound, max_bound);
+            mutated = true;
+        }
+        if((double)rand() / RAND_MAX < p_mutation){
+            node.x2 = randfloat(min_bound, max_bound);
+            mutated = true;
+        }
+        if(mutated){
+            mark_changed(i);
+            if(rate_control != NULL)
+                rate_control->mark(i, RateController::MUTATION);
+        }
     }
 }
 
@@ -114,18 +379,340 @@ void GAFloat::run(string mode, int times){
     best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
     initialize();
     evaluate();
+    if(trace != NULL)
+        trace->record(population);
+    mark_all_changed();
+    if(elite_size > 0){
+        archive = EliteArchive<cell>(elite_size, mode, [](const cell &node){
+            return hash<double>()(node.x1) * 31 + hash<double>()(node.x2);
+        });
+        update_archive();
+    }
     for(int iter=0;iter<max_iter;iter++){
         select(mode, times);
         crossover();
-        mutation();
-        evaluate();
-        int best_idx = find_best(mode);
+        if(dist != NULL){
+            // Pipeline: 每 mutate 完一個 batch 就送出, worker 計算的同時產生下一個 batch.
+            col_fitness.resize(population.size());
+            for(int b=0;b<population_size;b+=batch_size){
+                int e = min(b + batch_size, population_size);
+                mutation(b, e);
+                submit_batches(b, e);
+            }
+            collect();
+        }
+        else if(two_tier){
+            mutation();
+            evaluate_two_tier(mode);
+        }
+        else if(surrogate != NULL){
+            mutation();
+            evaluate_screened(mode);
+        }
+        else{
+            mutation();
+            evaluate();
+        }
+        if(trace != NULL)
+            trace->record(population);
+        if(rate_control != NULL)
+            rate_control->end_generation(population, mode, iter, p_crossover, p_mutation);
+        if(memetic_ratio > 0 && (iter + 1) % memetic_interval == 0)
+            local_search(mode);
+        int best_idx = (elite_size > 0) ? update_archive() : find_best(mode);
+        best_gene_list.push_back(best_idx);
+    }
+    int iter_interval = 200;
+    print_info(iter_interval);
+}
+
+// Memetic: 對 population 中最好的 memetic_ratio 比例的個體做 bounded local search,
+// 個體分給 local_threads 個 thread, 每個 thread 用自己的 mt19937.
+// 改善的個體直接取代原本的位置並標記為 changed, 之後的 update_archive 會看到.
+void GAFloat::local_search(string mode){
+    int k = min(population_size, (int)ceil(memetic_ratio * population_size));
+    vector<int> order(population_size);
+    for(int i=0;i<population_size;i++)
+        order[i] = i;
+    partial_sort(order.begin(), order.begin() + k, order.end(), [&](int a, int b){
+        return (mode == "max") ? population[a].fitness > population[b].fitness : population[a].fitness < population[b].fitness;
+    });
+
+    LocalSearch searcher(min_bound, max_bound, local_step, precision, mode, kernel());
+    int n_threads = max(1, min(local_threads, k));
+    vector<long> used(n_threads, 0);
+    vector<char> improved(k, 0);    // mark_changed 不是 thread-safe, 結束後再標記.
+    unsigned seed = rand();
+    run_workers(n_threads, [&](int w){
+        mt19937 rng(seed + w);
+        for(int j=w;j<k;j+=n_threads){
+            int i = order[j];
+            double before = population[i].fitness;
+            used[w] += searcher.climb(population[i], local_budget, rng);
+            improved[j] = (population[i].fitness != before);
+        }
+    });
+    for(int j=0;j<k;j++)
+        if(improved[j])
+            mark_changed(order[j]);
+    for(long u: used)
+        n_local_evals += u;
+}
+
+// run() 的 fused 版本: 每個 generation 只走過 population 一次.
+// 下一代寫在 pool, 以 tile_size 個為一個 tile, 對每個 tile 依序做
+// select -> crossover -> mutation -> evaluate -> 更新 best, 整個 tile 留在 cache 中.
+// 與 run() 的差別:
+//   1. crossover 的兩個個體在同一個 tile 內挑選;
+//   2. 沒被改過的個體直接沿用 parent 的 fitness, 只計算改過的個體 (trace 也只計入這些);
+//   3. 不支援 dist / two_tier / surrogate / rate_control.
+// tournament 仍然從整個上一代挑選, 這部分的讀取是隨機的, 所以先把 fitness 複製成連續的陣列.
+void GAFloat::run_tiled(string mode, int times){
+    best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
+    initialize();
+    evaluate();
+    if(trace != NULL)
+        trace->record(population);
+    mark_all_changed();
+    if(elite_size > 0){
+        archive = EliteArchive<cell>(elite_size, mode, [](const cell &node){
+            return hash<double>()(node.x1) * 31 + hash<double>()(node.x2);
+        });
+        update_archive();
+    }
+    else
+        find_best(mode);
+
+    bool maximize = (mode == "max");
+    auto better = [maximize](double a, double b){ return maximize ? a > b : a < b; };
+    BatchKernel fitness = kernel();
+    int tile = max(2, tile_size);
+    pool.resize(population_size);
+    tile_parents.resize(tile);
+    send_buf.resize(2 * tile);
+    col_fitness.resize(tile);
+    vector<int> offspring(tile);
+    vector<double> parent_fitness(population_size);
+    vector<cell> elites;
+    for(int iter=0;iter<max_iter;iter++){
+        // Elitism: 先決定 elite 放回的位置, 在對應的 tile 放入.
+        elites = archive.heap;
+        elite_slots.clear();
+        for(int k=0;k<(int)elites.size();k++)
+            elite_slots.push_back(rand() % population_size);
+
+        // tournament 只需要 fitness, 緊密排列後隨機讀取的 cache miss 較少.
+        for(int i=0;i<population_size;i++)
+            parent_fitness[i] = population[i].fitness;
+
+        int best_idx = 0;
+        for(int b=0;b<population_size;b+=tile){
+            int m = min(tile, population_size - b);
+            cell *next = &pool[b];
+
+            // Select.
+            for(int i=0;i<m;i++){
+                int select_idx = rand() % population_size;
+                for(int j=0;j<times;j++){
+                    int idx = rand() % population_size;
+                    if(better(parent_fitness[idx], parent_fitness[select_idx]))
+                        select_idx = idx;
+                }
+                tile_parents[i] = population[select_idx];
+            }
+            for(int k=0;k<(int)elites.size();k++)
+                if(elite_slots[k] >= b && elite_slots[k] < b + m)
+                    tile_parents[elite_slots[k] - b] = elites[k];
+            for(int i=0;i<m;i++){
+                next[i] = tile_parents[i];
+                changed[b + i] = 0;
+            }
+
+            // Crossover.
+            for(int i=0;i<m && m>1;i++){
+                if((double)rand() / RAND_MAX > p_crossover)  // Do not corssover.
+                    continue;
+                int idx1 = rand() % m, idx2 = rand() % m;
+                while(idx2 == idx1)
+                    idx2 = rand() % m;
+                next[idx1].x2 = tile_parents[idx2].x2;
+                next[idx2].x1 = tile_parents[idx1].x1;
+                changed[b + idx1] = changed[b + idx2] = 1;
+            }
+
+            // Mutation.
+            for(int i=0;i<m;i++){
+                if((double)rand() / RAND_MAX < p_mutation){
+                    next[i].x1 = randfloat(min_bound, max_bound);
+                    changed[b + i] = 1;
+                }
+                if((double)rand() / RAND_MAX < p_mutation){
+                    next[i].x2 = randfloat(min_bound, max_bound);
+                    changed[b + i] = 1;
+                }
+            }
+
+            // Evaluate: 只算改過的個體.
+            int n = 0;
+            for(int i=0;i<m;i++)
+                if(changed[b + i])
+                    offspring[n++] = i;
+            for(int j=0;j<n;j++){
+                send_buf[j] = next[offspring[j]].x1;
+                send_buf[n + j] = next[offspring[j]].x2;
+            }
+            if(n > 0)
+                fitness(send_buf.data(), n, 2, col_fitness.data());
+            for(int j=0;j<n;j++){
+                cell &node = next[offspring[j]];
+                node.fitness = col_fitness[j];
+                if(trace != NULL)
+                    trace->record(node.fitness);
+                if(elite_size > 0)
+                    archive.offer(node);
+            }
+
+            // 更新 best.
+            for(int i=0;i<m;i++){
+                if(better(next[i].fitness, pool[best_idx].fitness))
+                    best_idx = b + i;
+                if(better(next[i].fitness, best_cell.fitness)){
+                    best_cell = next[i];
+                    best_iter = cur_iter + 1;
+                }
+            }
+        }
+        population.swap(pool);
+        cur_iter++;
         best_gene_list.push_back(best_idx);
     }
     int iter_interval = 200;
     print_info(iter_interval);
 }
 
+// 非同步 steady-state: 每個 worker 各自挑 parent 產生一個 offspring, 算完
+// fitness 後以 tournament 找出較差的個體取代, 不需等整個 generation.
+// 總 evaluation 數與 run() 相同 (max_iter * population_size), best_iter 以
+// generation 為單位換算.
+void GAFloat::run_steady_state(string mode, int times, int n_threads){
+    best_cell.fitness = (mode == "max") ? INT_MIN : INT_MAX;
+    initialize();
+    evaluate();
+    for(auto& node: population)
+        if((mode == "max" && node.fitness > best_cell.fitness) || (mode == "min" && node.fitness < best_cell.fitness)){
+            best_cell = node;
+            best_iter = 0;
+        }
+
+    BatchKernel fitness = kernel();
+    long budget = (long)max_iter * population_size;
+    atomic<long> n_started(0);
+    long n_done = 0;
+    mutex lock;
+    vector<double> busy(n_threads, 0.0);
+    unsigned seed = rand();
+    auto better = [&](double a, double b){ return (mode == "max") ? a > b : a < b; };
+    auto start = chrono::steady_clock::now();
+
+    run_workers(n_threads, [&](int w){
+        mt19937 rng(seed + w);
+        uniform_int_distribution<int> pick(0, population_size - 1);
+        uniform_real_distribution<double> unit(0.0, 1.0), gene(min_bound, max_bound);
+        while(n_started++ < budget){
+            cell child, mate;
+            {
+                lock_guard<mutex> guard(lock);
+                int a = pick(rng), b = pick(rng);
+                for(int j=0;j<times;j++){
+                    int idx = pick(rng);
+                    if(better(population[idx].fitness, population[a].fitness))
+                        a = idx;
+                    idx = pick(rng);
+                    if(better(population[idx].fitness, population[b].fitness))
+                        b = idx;
+                }
+                child = population[a];
+                mate = population[b];
+            }
+            if(unit(rng) < p_crossover)
+                child.x2 = mate.x2;
+            if(unit(rng) < p_mutation)
+                child.x1 = gene(rng);
+            if(unit(rng) < p_mutation)
+                child.x2 = gene(rng);
+
+            auto t0 = chrono::steady_clock::now();
+            double cols[2] = {child.x1, child.x2};
+            fitness(cols, 1, 2, &child.fitness);
+            busy[w] += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+            lock_guard<mutex> guard(lock);
+            // 反向 tournament: 取代 times 個隨機個體中最差的一個.
+            int worst = pick(rng);
+            for(int j=0;j<times;j++){
+                int idx = pick(rng);
+                if(better(population[worst].fitness, population[idx].fitness))
+                    worst = idx;
+            }
+            if(!better(population[worst].fitness, child.fitness))
+                population[worst] = child;
+            n_done++;
+            if(better(child.fitness, best_cell.fitness)){
+                best_cell = child;
+                best_iter = n_done / population_size;
+            }
+        }
+    });
+
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double total_busy = 0;
+    for(double b: busy)
+        total_busy += b;
+    utilization = (wall > 0) ? total_busy / (wall * n_threads) : 0;
+    cur_iter = max_iter;
+
+    cout<<"Steady-state threads: "<<n_threads<<", evaluations: "<<n_done
+        <<", wall: "<<wall<<"s, utilization: "<<utilization * 100<<"%\n";
+    int iter_interval = 200;
+    print_info(iter_interval);
+}
+
+void GAFloat::mark_changed(int k){
+    if(!changed[k]){
+        changed[k] = 1;
+        changed_list.push_back(k);
+    }
+}
+
+void GAFloat::mark_all_changed(){
+    changed.assign(population_size, 1);
+    changed_list.resize(population_size);
+    for(int i=0;i<population_size;i++)
+        changed_list[i] = i;
+}
+
+// find_best 的 incremental 版本: 只把這個 generation 改過的個體交給 archive,
+// best_cell 取自 archive. 回傳的 index 只在改過的個體與 elite 的位置中挑選,
+// 所以每個 generation 的成本與改過的個體數成正比, 不必掃過整個 population.
+int GAFloat::update_archive(){
+    cur_iter++;
+    int idx = elite_slots.empty() ? 0 : elite_slots[0];
+    for(int i: changed_list){
+        archive.offer(population[i]);
+        if(archive.better(population[i], population[idx]))
+            idx = i;
+    }
+    for(int slot: elite_slots)
+        if(archive.better(population[slot], population[idx]))
+            idx = slot;
+
+    if(archive.better(archive.best_cell, best_cell)){
+        best_cell = archive.best_cell;
+        best_iter = cur_iter;
+    }
+    return idx;
+}
+
 int GAFloat::find_best(string mode){
     cur_iter++;
     int idx;
@@ -177,18 +764,143 @@ void GAFloat::print_info(int iter_interval){
     cout<<"All best iter: "<<best_iter<<endl;
 }
 
-int main(){
+#ifndef GA_NO_MAIN    // pyga.cpp 等其他程式 include 這個檔案時不需要 main.
+// ./ga_float.out [options] ["fitness expression" [min_bound max_bound]]
+//   --local N           fork N 個本機 worker 計算 fitness
+//   --connect host:port 連到其他機器上的 worker (可重複)
+//   --worker port       當作 worker, 等 master 連線
+//   --steady N          非同步 steady-state, N 個 thread (不能與 evaluation 相關的選項合用)
+//   --tiled SIZE        fused generation, 每 SIZE 個個體為一個 tile (不能與 evaluation 相關的選項合用)
+//   --memetic RATIO     每 10 個 generation 對最好的 RATIO 比例做 local search
+//   --ls-budget N       每個個體 local search 最多 N 次 evaluation
+//   --surrogate RATIO   用 kNN surrogate 篩選, 只真正計算 RATIO 比例的 offspring (不能與 --local / --connect 合用)
+//   --two-tier TOL      先用 float 篩選, tournament 誤差不超過 TOL (只支援內建的 fitness, 不能與 --local / --connect / --surrogate 合用)
+//   --peaks K           結束後對 population 與 elite 分群, 列出前 K 個山峰
+//   --adapt RULE        依 operator 成功率調整 p_crossover / p_mutation (success 或 pursuit)
+//   --rate-history FILE 把每個 generation 的機率與成功次數寫成 CSV
+//   --sampler KIND      初始 population 改用 sobol, halton 或 lhs
+//   --pin               --steady / --memetic 的 thread 依 NUMA node 固定在 cpu 上
+int main(int argc, char *argv[]){
     srand((unsigned)time(NULL));  // (unsigned)time(NULL)
 
-    int max_iter=10000, population_size=100, min_bound=0, max_bound=1;
+    int n_local = 0, worker_port = 0, n_steady = 0, n_peaks = 0, tile_size = 0;
+    float surrogate_ratio = 0, two_tier_tolerance = 0, memetic_ratio = 0;
+    long local_budget = 300;
+    string adapt_rule, rate_history, sampler_kind;
+    vector<string> remotes, args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--local" && i + 1 < argc)
+            n_local = atoi(argv[++i]);
+        else if(arg == "--connect" && i + 1 < argc)
+            remotes.push_back(argv[++i]);
+        else if(arg == "--worker" && i + 1 < argc)
+            worker_port = atoi(argv[++i]);
+        else if(arg == "--steady" && i + 1 < argc)
+            n_steady = atoi(argv[++i]);
+        else if(arg == "--tiled" && i + 1 < argc)
+            tile_size = atoi(argv[++i]);
+        else if(arg == "--memetic" && i + 1 < argc)
+            memetic_ratio = atof(argv[++i]);
+        else if(arg == "--ls-budget" && i + 1 < argc)
+            local_budget = atol(argv[++i]);
+        else if(arg == "--surrogate" && i + 1 < argc)
+            surrogate_ratio = atof(argv[++i]);
+        else if(arg == "--two-tier" && i + 1 < argc)
+            two_tier_tolerance = atof(argv[++i]);
+        else if(arg == "--peaks" && i + 1 < argc)
+            n_peaks = atoi(argv[++i]);
+        else if(arg == "--adapt" && i + 1 < argc)
+            adapt_rule = argv[++i];
+        else if(arg == "--rate-history" && i + 1 < argc)
+            rate_history = argv[++i];
+        else if(arg == "--sampler" && i + 1 < argc)
+            sampler_kind = argv[++i];
+        else if(arg == "--pin")
+            pin_workers = true;
+        else
+            args.push_back(arg);
+    }
+
+    int max_iter=10000, population_size=100;
+    float min_bound=0, max_bound=1;
     float precision=0.0001, p_mutation=0.01, p_crossover=0.25;
-    
+
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+
+    // run_tiled 只有 select / crossover / mutation 與 kernel(), 不支援其他的 evaluation 方式.
+    if(tile_size > 0){
+        string conflicts;
+        if(n_local > 0) conflicts += " --local";
+        if(!remotes.empty()) conflicts += " --connect";
+        if(n_steady > 0) conflicts += " --steady";
+        if(surrogate_ratio > 0) conflicts += " --surrogate";
+        if(two_tier_tolerance > 0) conflicts += " --two-tier";
+        if(memetic_ratio > 0) conflicts += " --memetic";
+        if(!adapt_rule.empty()) conflicts += " --adapt";
+        if(!conflicts.empty()){
+            cout<<"--tiled cannot be combined with"<<conflicts<<"\n";
+            return 1;
+        }
+    }
+    // run_steady_state 的 worker 直接呼叫 kernel(), 一次只算一個 offspring.
+    if(n_steady > 0){
+        string conflicts;
+        if(n_local > 0) conflicts += " --local";
+        if(!remotes.empty()) conflicts += " --connect";
+        if(surrogate_ratio > 0) conflicts += " --surrogate";
+        if(two_tier_tolerance > 0) conflicts += " --two-tier";
+        if(memetic_ratio > 0) conflicts += " --memetic";
+        if(!adapt_rule.empty()) conflicts += " --adapt";
+        if(!conflicts.empty()){
+            cout<<"--steady cannot be combined with"<<conflicts<<"\n";
+            return 1;
+        }
+    }
+    // run() 每個 generation 只用一種 evaluation 方式 (dist, two_tier, surrogate),
+    // two_tier 的 float 版本也只有內建的 fitness.
+    if(two_tier_tolerance > 0){
+        string conflicts;
+        if(fitness_expr != NULL) conflicts += " a fitness expression";
+        if(n_local > 0) conflicts += " --local";
+        if(!remotes.empty()) conflicts += " --connect";
+        if(surrogate_ratio > 0) conflicts += " --surrogate";
+        if(!conflicts.empty()){
+            cout<<"--two-tier cannot be combined with"<<conflicts<<"\n";
+            return 1;
+        }
+    }
+    if(surrogate_ratio > 0){
+        string conflicts;
+        if(n_local > 0) conflicts += " --local";
+        if(!remotes.empty()) conflicts += " --connect";
+        if(!conflicts.empty()){
+            cout<<"--surrogate cannot be combined with"<<conflicts<<"\n";
+            return 1;
+        }
+    }
+
+    Sampler *sampler = sampler_kind.empty() ? NULL : new Sampler(sampler_kind, 2, rand());
+
+    if(worker_port > 0){
+        GAFloat ga(max_iter, population_size, min_bound, max_bound, precision, p_mutation, p_crossover);
+        ga.fitness_expr = fitness_expr;
+        serve_tcp(worker_port, ga.kernel());
+        return 0;
+    }
 
     string mode = "max";
     int times = 5;
+    int elite_size = 2;
 
     // 收集實驗數據用於計算平均和最大最小值範圍
-    vector<float> total_fitness, total_iter, total_x1, total_x2;
+    StreamStats total_fitness, total_iter, total_x1, total_x2;
     // 收集數據之實驗次數
     int exp_num=1;
     for(int exp=0;exp<exp_num;exp++){
@@ -201,13 +913,91 @@ int main(){
         precision,
         p_mutation,
         p_crossover);
+        ga.fitness_expr = fitness_expr;
+        // steady-state 只取代 tournament 中最差的個體, 最好的個體不會被換掉, 不需要 elite.
+        ga.elite_size = (n_steady > 0) ? 0 : elite_size;
+
+        DistEvaluator dist;
+        if(n_local > 0)
+            dist.spawn_local(n_local, ga.kernel());
+        for(string remote: remotes){
+            int colon = remote.rfind(':');
+            dist.connect_tcp(remote.substr(0, colon), atoi(remote.substr(colon + 1).c_str()));
+        }
+        if(dist.num_workers() > 0)
+            ga.dist = &dist;
+
+        KnnSurrogate surrogate(8, min_bound, max_bound);
+        if(surrogate_ratio > 0){
+            ga.surrogate = &surrogate;
+            ga.surrogate_ratio = surrogate_ratio;
+        }
+
+        if(two_tier_tolerance > 0){
+            ga.two_tier = true;
+            ga.tolerance = two_tier_tolerance;
+        }
 
-        ga.run(mode, times);
+        ga.sampler = sampler;
+
+        ga.memetic_ratio = memetic_ratio;
+        ga.local_budget = local_budget;
+
+        RateController *rate_control = NULL;
+        if(!adapt_rule.empty()){
+            rate_control = new RateController(adapt_rule);
+            ga.rate_control = rate_control;
+        }
+
+        if(n_steady > 0)
+            ga.run_steady_state(mode, times, n_steady);
+        else if(tile_size > 0){
+            ga.tile_size = tile_size;
+            ga.run_tiled(mode, times);
+        }
+        else
+            ga.run(mode, times);
+        if(ga.surrogate != NULL)
+            cout<<"Real evaluations: "<<ga.n_real_evals<<", saved by surrogate: "<<ga.n_saved_evals<<endl;
+        if(ga.memetic_ratio > 0)
+            cout<<"GA evaluations: "<<(long)(ga.max_iter + 1) * ga.population_size
+                <<", local search evaluations: "<<ga.n_local_evals<<endl;
+        if(ga.two_tier)
+            cout<<"same as parent: "<<ga.n_reused<<", float only: "<<ga.n_screened<<", refined in double: "<<ga.n_refined
+                <<", max error / bound: "<<ga.max_error_ratio<<endl;
+        if(rate_control != NULL){
+            cout<<"Adapted p_crossover: "<<ga.p_crossover<<", p_mutation: "<<ga.p_mutation<<endl;
+            if(!rate_history.empty())
+                rate_control->save_history(rate_history);
+            delete rate_control;
+        }
+        if(n_peaks > 0){
+            vector<double> x1, x2, fitness;
+            set<pair<double, double>> in_population;
+            for(const cell &node: ga.population){
+                x1.push_back(node.x1);
+                x2.push_back(node.x2);
+                fitness.push_back(node.fitness);
+                in_population.insert({node.x1, node.x2});
+            }
+            // elite 每個 generation 都被放回 population, 還在 population 裡的不要再算一次.
+            for(const cell &node: ga.archive.heap){
+                if(in_population.count({node.x1, node.x2}))
+                    continue;
+                x1.push_back(node.x1);
+                x2.push_back(node.x2);
+                fitness.push_back(node.fitness);
+            }
+            vector<Peak> peaks = find_peaks(x1, x2, fitness, 0.25 * (max_bound - min_bound), 3, mode);
+            for(int i=0;i<(int)peaks.size() && i<n_peaks;i++)
+                cout<<"Peak "<<i<<": fitness = "<<peaks[i].fitness<<", (x1, x2) = ("<<peaks[i].x1<<", "
+                    <<peaks[i].x2<<"), basin size = "<<peaks[i].basin_size<<endl;
+        }
 
-        total_fitness.push_back(ga.best_cell.fitness);
-        total_x1.push_back(ga.best_cell.x1);
-        total_x2.push_back(ga.best_cell.x2);
-        total_iter.push_back(ga.best_iter);
+        total_fitness.add(ga.best_cell.fitness);
+        total_x1.add(ga.best_cell.x1);
+        total_x2.add(ga.best_cell.x2);
+        total_iter.add(ga.best_iter);
         
     }
 
@@ -215,12 +1005,13 @@ int main(){
     cout<<"===\n";
     cout<<"|name|stats|\n";
     cout<<"|-|-|\n";
-    cout<<"|fitness mean| "<<setprecision(6)<<find_sum(total_fitness)/ exp_num<<"|\n";
-    cout<<"|iter mean   | "<<find_sum(total_iter) / exp_num<<"|\n";
-    cout<<"|x1 mean     | "<<setprecision(4)<<find_sum(total_x1) / exp_num<<"|\n";
-    cout<<"|x2 mean     | "<<setprecision(4)<<find_sum(total_x2) / exp_num<<"|\n";
+    cout<<"|fitness mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+    cout<<"|iter mean   | "<<total_iter.mean<<"|\n";
+    cout<<"|x1 mean     | "<<setprecision(4)<<total_x1.mean<<"|\n";
+    cout<<"|x2 mean     | "<<setprecision(4)<<total_x2.mean<<"|\n";
 
     find_range(total_fitness, "fitness");
+    find_ci(total_fitness, "fitness");
     find_range(total_iter, "iter");
     find_range(total_x1, "x1");
     find_range(total_x2, "x2");
@@ -228,3 +1019,4 @@ int main(){
     cout<<"\n Now mode: "<<mode<<endl;
     cout<<"GA float string\n";
 }
+#endif
@@ -1,3 +1,5 @@
+#ifndef GA_UTIL_H
+#define GA_UTIL_H
 #include<iostream>
 #include<cmath>
 #include<cstdlib>   // 亂數相關函數
@@ -7,16 +9,33 @@
 #include <numeric> 
 #include <bits/stdc++.h>
 #include<iomanip>
+#include"stream_stats.h"
 using namespace std;
 
-float find_sum(vector<float> a){
+template<class T>
+double find_sum(const vector<T> &a){
     return std::accumulate(a.begin(), a.end(), 0.0);
 }
-void find_range(vector<float> a, string tar){
+
+template<class T>
+void find_range(const vector<T> &a, string tar){
     cout<<"|"<<tar<<" range ";
     double max = *max_element(a.begin(), a.end());
     double min = *min_element(a.begin(), a.end());
     cout<<"(min, max) | ("<<setprecision(4)<<min<<", "<<max<<")|\n";
 }
 
+void find_range(StreamStats &a, string tar){
+    cout<<"|"<<tar<<" range ";
+    cout<<"(min, max) | ("<<setprecision(4)<<a.min<<", "<<a.max<<")|\n";
+}
+
+// mean 的 95% 信賴區間與中位數, 實驗只有一次時不印.
+void find_ci(StreamStats &a, string tar){
+    if(a.n < 2)
+        return;
+    cout<<"|"<<tar<<" 95% CI, median | ("<<setprecision(4)<<a.mean - a.ci95()<<", "<<a.mean + a.ci95()
+        <<"), "<<a.quantile(0.5)<<"|\n";
+}
 
+#endif
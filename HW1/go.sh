@@ -1,13 +1,71 @@
 g++ ga_binary_string.cpp -o ga_binary_string.out
 ./ga_binary_string.out
+# ./ga_binary_string.out "x1 + x2" -3 3       # 16 bits
+# ./ga_binary_string.out "x1 + x2" 0 100000  # 30 bits, runtime length
 
 
-# g++ ga_float.cpp -o ga_float.out
+# g++ -pthread ga_float.cpp -o ga_float.out
 # ./ga_float.out
+# ./ga_float.out --local 4
+# ./ga_float.out --steady 8
+# ./ga_float.out --tiled 256
+# ./ga_float.out --memetic 0.1 --ls-budget 300
+# ./ga_float.out --surrogate 0.3
+# ./ga_float.out --two-tier 1e-4
+# ./ga_float.out --peaks 4
+# ./ga_float.out --adapt pursuit --rate-history rates.csv
+# ./ga_float.out --worker 5555 &   ./ga_float.out --connect node1:5555 --connect node2:5555
+# ./ga_float.out "80 - x**2 - y**2 + 10*cos(2*pi*x) + 10*cos(2*pi*y)" -0.5 1.5
 
 # g++ hill_climbing.cpp -o hill_climbing.out
 # ./hill_climbing.out
 
 
 # g++ anneling.cpp -o anneling.out
-# ./anneling.out
\ No newline at end of file
+# ./anneling.out
+
+
+# g++ -O2 -pthread landscape.cpp -o landscape.out
+# ./landscape.out q1 q1.raw -0.5:1.5:4096 -0.5:1.5:4096
+
+
+# g++ -O2 -shared -fPIC -std=c++17 -pthread $(python3-config --includes) pyga.cpp -o pyga$(python3-config --extension-suffix)
+# python3 -c "import pyga; ga = pyga.GAFloat(max_iter=2000); ga.run('max', 5); print(ga.best, memoryview(ga.population).shape)"
+
+
+# g++ -O2 -pthread sweep.cpp -o sweep.out
+# ./sweep.out sweep.cfg sweep.cols
+
+
+# g++ -O2 -pthread anytime.cpp -o anytime.out
+# ./anytime.out --runs 25 --budget 100000 --out anytime.ecdf
+# ./anytime.out --mode min "20 + x**2 + y**2 - 10*cos(2*pi*x) - 10*cos(2*pi*y)" -5 5
+
+
+# g++ -O2 -pthread evolution.cpp -o evolution.out
+# ./evolution.out --engine cmaes
+# ./evolution.out --engine de --evals 20000 "-(100*((x1-0.3)+(x2-0.6))**2 + ((x1-0.3)-(x2-0.6))**2)" -1 1
+
+
+# g++ tabu_search.cpp -o tabu_search.out
+# ./tabu_search.out
+
+
+# g++ -O2 -pthread stream_ga.cpp -o stream_ga.out
+# ./stream_ga.out --size 100000000 --iter 20 --dir /data/ga
+
+
+# -ffast-math 讓 g++ 用 glibc 的向量版 pow / sin, 每個 lane 一個 SIMD 元素.
+# g++ -O3 -march=native -ffast-math batch_chains.cpp -o batch_chains.out
+# ./batch_chains.out --compare
+# ./batch_chains.out --kind anneal --chains 300 --mode max
+
+
+# 起點 / 鄰居改用 low-discrepancy 點 (low_discrepancy.h).
+# ./hill_climbing.out --sampler sobol --move-sampler lhs
+# ./ga_float.out --sampler halton
+
+
+# 多個 NUMA node 的機器: worker 固定在 cpu 上, 輸出 page 由各自的 worker 先寫入.
+# ./landscape.out q1 q1.raw -0.5:1.5:8192 -0.5:1.5:8192 --pin
+# ./ga_float.out --pin --steady 32
@@ -0,0 +1,145 @@
+#include<iostream>
+#include<cstdlib>
+#include<cstring>
+#include<cstdint>
+#include<string>
+#include<vector>
+#include<atomic>
+#include<chrono>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include"fitness.h"
+#include"parallel.h"
+using namespace std;
+
+// 在密集的網格上計算 fitness, 結果直接寫進 memory-mapped 的檔案.
+// 檔案為 LANDSCAPE_HEADER bytes 的 header 加上 row-major 的 float64 陣列
+// (最後一個維度變化最快), numpy 可以直接讀取而不需複製:
+//   np.memmap(path, dtype='<f8', mode='r', offset=256, shape=(n_1, ..., n_d))
+const int LANDSCAPE_HEADER = 256;
+const int LANDSCAPE_MAX_DIM = 8;
+
+struct LandscapeHeader{
+    char magic[8];          // "GALAND1"
+    uint32_t header_size;   // LANDSCAPE_HEADER
+    uint32_t ndim;
+    uint64_t n[LANDSCAPE_MAX_DIM];
+    double lo[LANDSCAPE_MAX_DIM], hi[LANDSCAPE_MAX_DIM];
+};
+
+static_assert(sizeof(LandscapeHeader) <= LANDSCAPE_HEADER, "header too large");
+
+struct Axis{
+    double lo, hi;
+    long n;
+    double at(long i){ return (n > 1) ? lo + (hi - lo) * i / (n - 1) : lo; }
+};
+
+// 每個 thread 一次處理 BLOCK 個格點: 先把 flat index 換成座標 column,
+// 再呼叫 batch kernel, 結果直接寫進 out.
+// pin_workers 時每個 worker 只寫自己的 worker_slice, 輸出的 page 第一次由它寫入,
+// 因此落在該 worker 的 NUMA node; 否則以 atomic counter 動態分配 block.
+void sample(BatchKernel fitness, vector<Axis> &axes, double *out, long total, int n_threads){
+    const long BLOCK = 4096;
+    int dim = axes.size();
+    atomic<long> next(0);
+    run_workers(n_threads, [&](int w){
+        vector<double> cols(BLOCK * dim);
+        pair<long, long> slice = worker_slice(total, w, n_threads);
+        long begin = slice.first - BLOCK;
+        while(pin_workers ? (begin += BLOCK) < slice.second : (begin = next.fetch_add(BLOCK)) < total){
+            long m = min(BLOCK, (pin_workers ? slice.second : total) - begin);
+            for(long i=0;i<m;i++){
+                long rest = begin + i;
+                for(int d=dim-1;d>=0;d--){
+                    cols[d * m + i] = axes[d].at(rest % axes[d].n);
+                    rest /= axes[d].n;
+                }
+            }
+            fitness(cols.data(), m, dim, out + begin);
+        }
+    });
+}
+
+// ./landscape.out FUNC OUT.raw lo:hi:n [lo:hi:n ...] [--threads N] [--pin]
+//   --pin: worker 固定在各 NUMA node 的 cpu 上, 結束後列出輸出 page 的分布
+//   FUNC: hw1, q1, 或以 x1 ... xd 為變數的運算式
+//   例如: ./landscape.out q1 q1.raw -0.5:1.5:4096 -0.5:1.5:4096
+int main(int argc, char *argv[]){
+    int n_threads = default_threads();
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--threads" && i + 1 < argc)
+            n_threads = atoi(argv[++i]);
+        else if(arg == "--pin")
+            pin_workers = true;
+        else
+            args.push_back(arg);
+    }
+    if(args.size() < 3){
+        cout<<"usage: "<<argv[0]<<" FUNC OUT.raw lo:hi:n [lo:hi:n ...] [--threads N] [--pin]\n";
+        return 1;
+    }
+
+    vector<Axis> axes;
+    long total = 1;
+    for(int i=2;i<(int)args.size();i++){
+        Axis axis;
+        if(sscanf(args[i].c_str(), "%lf:%lf:%ld", &axis.lo, &axis.hi, &axis.n) != 3 || axis.n <= 0){
+            cout<<"bad axis: "<<args[i]<<"\n";
+            return 1;
+        }
+        axes.push_back(axis);
+        total *= axis.n;
+    }
+    if((int)axes.size() > LANDSCAPE_MAX_DIM){
+        cout<<"at most "<<LANDSCAPE_MAX_DIM<<" dimensions\n";
+        return 1;
+    }
+    BatchKernel fitness;
+    try{
+        fitness = find_fitness(args[0], axes.size());
+    }
+    catch(const exception &e){
+        cout<<e.what()<<"\n";
+        return 1;
+    }
+
+    size_t bytes = LANDSCAPE_HEADER + total * sizeof(double);
+    int fd = open(args[1].c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0 || ftruncate(fd, bytes) < 0){
+        cout<<"cannot create "<<args[1]<<"\n";
+        return 1;
+    }
+    char *map = (char*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED){
+        cout<<"mmap failed\n";
+        return 1;
+    }
+
+    LandscapeHeader head;
+    memset(&head, 0, sizeof(head));
+    strcpy(head.magic, "GALAND1");
+    head.header_size = LANDSCAPE_HEADER;
+    head.ndim = axes.size();
+    for(int d=0;d<(int)axes.size();d++){
+        head.n[d] = axes[d].n;
+        head.lo[d] = axes[d].lo;
+        head.hi[d] = axes[d].hi;
+    }
+    memcpy(map, &head, sizeof(head));
+
+    auto start = chrono::steady_clock::now();
+    sample(fitness, axes, (double*)(map + LANDSCAPE_HEADER), total, n_threads);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout<<"Sampled "<<total<<" points with "<<n_threads<<" threads in "<<elapsed<<"s -> "<<args[1]<<"\n";
+    if(pin_workers){
+        PlacementStats stats = placement_stats(map + LANDSCAPE_HEADER, total * sizeof(double), n_threads);
+        print_placement(stats, n_threads);
+    }
+    munmap(map, bytes);
+    close(fd);
+}
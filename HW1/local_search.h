@@ -0,0 +1,74 @@
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+#include<cmath>
+#include<string>
+#include<vector>
+#include<random>
+#include"fitness.h"
+using namespace std;
+
+// HillClimbing::move() / check_bound() 的鄰域, 改成可以在多個 thread 中同時使用:
+// 亂數由呼叫者的 mt19937 提供, 每一步的 n_neighbors 個點以 BatchKernel 一次算完.
+// 與 HillClimbing 不同, 找不到更好的點時不會馬上停止, 而是把 step 減半,
+// 直到 step 小於 min_step 或用完 budget, 所以最後的精度約為 min_step.
+class LocalSearch{
+public:
+    float min_bound, max_bound;
+    double step, min_step;
+    int n_neighbors = 30;
+    string mode;
+    BatchKernel fitness;
+    LocalSearch(float min_bound, float max_bound, double step, double min_step, string mode, BatchKernel fitness);
+    void check_bound(double &x1, double &x2);
+    template<class Cell> long climb(Cell &node, long budget, mt19937 &rng);
+};
+
+LocalSearch::LocalSearch(float min_bound, float max_bound, double step, double min_step, string mode, BatchKernel fitness){
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    this->step = step;
+    this->min_step = min_step;
+    this->mode = mode;
+    this->fitness = fitness;
+}
+
+void LocalSearch::check_bound(double &x1, double &x2){
+    if(x1 < min_bound) x1 = min_bound;
+    if(x1 > max_bound) x1 = max_bound;
+    if(x2 < min_bound) x2 = min_bound;
+    if(x2 > max_bound) x2 = max_bound;
+}
+
+// 從 node 開始爬, 結果寫回 node, 回傳用掉的 evaluation 數 (不超過 budget).
+template<class Cell>
+long LocalSearch::climb(Cell &node, long budget, mt19937 &rng){
+    vector<double> cols(2 * n_neighbors), out(n_neighbors);
+    double cur_step = step;
+    long used = 0;
+    while(cur_step >= min_step && used + n_neighbors <= budget){
+        uniform_real_distribution<double> delta(-cur_step, cur_step);
+        for(int i=0;i<n_neighbors;i++){
+            double x1 = node.x1 + delta(rng), x2 = node.x2 + delta(rng);
+            check_bound(x1, x2);
+            cols[i] = x1;
+            cols[n_neighbors + i] = x2;
+        }
+        fitness(cols.data(), n_neighbors, 2, out.data());
+        used += n_neighbors;
+
+        int idx = 0;
+        for(int i=1;i<n_neighbors;i++)
+            if((mode == "max") ? out[i] > out[idx] : out[i] < out[idx])
+                idx = i;
+        if((mode == "max") ? out[idx] > node.fitness : out[idx] < node.fitness){
+            node.x1 = cols[idx];
+            node.x2 = cols[n_neighbors + idx];
+            node.fitness = out[idx];
+        }
+        else
+            cur_step /= 2;
+    }
+    return used;
+}
+
+#endif
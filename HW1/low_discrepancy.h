@@ -0,0 +1,193 @@
+#ifndef LOW_DISCREPANCY_H
+#define LOW_DISCREPANCY_H
+#include<cmath>
+#include<cstdint>
+#include<string>
+#include<vector>
+#include<random>
+#include<algorithm>
+#include<stdexcept>
+using namespace std;
+
+// 取代 initialize() / move() 中獨立的 rand(), 讓點比較均勻地蓋住整個範圍.
+//   sobol:  Joe-Kuo direction numbers (最多 8 維), 以 Gray code 遞推, 每點每維一次 XOR;
+//           Owen scrambling 用 Laine-Karras hash (Burley 2020), 每維一個 seed.
+//   halton: 第 d 維以第 d 個質數為底, 每一位數有自己的隨機排列 (random digit scrambling).
+//   lhs:    Latin hypercube, 每次 next() 的 n 個點在每一維都恰好一個落在 n 等分的每一格.
+// next() 產生的點與 BatchKernel 相同是 column: 第 j 維在 cols + j*n.
+// restart() 換一組新的 scrambling 並從第 0 點開始, 每次都是獨立的 randomized QMC 點集.
+class Sampler{
+public:
+    string kind;    // "sobol", "halton" or "lhs".
+    int dim;
+    long index = 0;                 // 下一個點在序列中的位置.
+    mt19937 rng;
+    vector<uint32_t> seeds;         // sobol: 每一維的 scrambling seed.
+    vector<vector<uint32_t>> directions;    // sobol: 每一維 32 個 direction number.
+    vector<int> bases, n_digits;    // halton: 每一維的底與位數.
+    vector<vector<int>> perms;      // halton: perms[d][k * base + digit].
+    Sampler(string kind, int dim, unsigned seed);
+    void restart();
+    void next(int n, double *cols);
+    void next(int n, double *cols, double lo, double hi);
+    void sobol(int n, double *cols);
+    void halton(int n, double *cols);
+    void lhs(int n, double *cols);
+};
+
+// new-joe-kuo-6.21201 的第 2 ~ 8 維: degree s, 係數 a, 初始 m_1 ... m_s.
+struct SobolPoly{ int s, a; int m[5]; };
+const SobolPoly sobol_polys[] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+};
+
+Sampler::Sampler(string kind, int dim, unsigned seed): rng(seed){
+    if(kind != "sobol" && kind != "halton" && kind != "lhs")
+        throw runtime_error("unknown sampler: " + kind);
+    this->kind = kind;
+    this->dim = dim;
+    if(kind == "sobol"){
+        if(dim > 8)
+            throw runtime_error("sobol sampler supports at most 8 dimensions");
+        directions.assign(dim, vector<uint32_t>(32));
+        for(int k=0;k<32;k++)
+            directions[0][k] = 1U << (31 - k);
+        for(int d=1;d<dim;d++){
+            const SobolPoly &p = sobol_polys[d - 1];
+            vector<uint32_t> &v = directions[d];
+            for(int k=0;k<p.s;k++)
+                v[k] = (uint32_t)p.m[k] << (31 - k);
+            for(int k=p.s;k<32;k++){
+                v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+                for(int j=1;j<p.s;j++)
+                    if((p.a >> (p.s - 1 - j)) & 1)
+                        v[k] ^= v[k - j];
+            }
+        }
+    }
+    else if(kind == "halton"){
+        for(int b=2;(int)bases.size()<dim;b++){
+            bool prime = true;
+            for(int q=2;q*q<=b;q++)
+                if(b % q == 0)
+                    prime = false;
+            if(!prime)
+                continue;
+            bases.push_back(b);
+            // 位數足夠讓解析度到 2^-32.
+            n_digits.push_back((int)ceil(32 / log2((double)b)));
+        }
+    }
+    restart();
+}
+
+void Sampler::restart(){
+    index = 0;
+    if(kind == "sobol"){
+        seeds.resize(dim);
+        for(int d=0;d<dim;d++)
+            seeds[d] = rng();
+    }
+    else if(kind == "halton"){
+        perms.resize(dim);
+        for(int d=0;d<dim;d++){
+            int b = bases[d];
+            perms[d].resize(b * n_digits[d]);
+            for(int k=0;k<n_digits[d];k++){
+                int *p = &perms[d][k * b];
+                for(int i=0;i<b;i++)
+                    p[i] = i;
+                shuffle(p, p + b, rng);
+            }
+        }
+    }
+}
+
+void Sampler::next(int n, double *cols){
+    if(kind == "sobol")
+        sobol(n, cols);
+    else if(kind == "halton")
+        halton(n, cols);
+    else
+        lhs(n, cols);
+    index += n;
+}
+
+void Sampler::next(int n, double *cols, double lo, double hi){
+    next(n, cols);
+    for(long i=0;i<(long)n*dim;i++)
+        cols[i] = lo + (hi - lo) * cols[i];
+}
+
+uint32_t reverse_bits(uint32_t x){
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+    x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Owen scrambling: 每一個 bit 依它上面所有 bit 決定是否翻轉.
+uint32_t owen_scramble(uint32_t x, uint32_t seed){
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cU;
+    x ^= x * 0xb82f1e52U;
+    x ^= x * 0xc7afe638U;
+    x ^= x * 0x8d22f6e6U;
+    return reverse_bits(x);
+}
+
+void Sampler::sobol(int n, double *cols){
+    for(int d=0;d<dim;d++){
+        const uint32_t *v = directions[d].data();
+        uint32_t gray = index ^ (index >> 1), x = 0;
+        for(int k=0;gray;k++, gray>>=1)
+            if(gray & 1)
+                x ^= v[k];
+        double *out = cols + (long)d * n;
+        for(int i=0;i<n;i++){
+            out[i] = (owen_scramble(x, seeds[d]) + 0.5) * 0x1.0p-32;
+            x ^= v[__builtin_ctzl(index + i + 1)];
+        }
+    }
+}
+
+void Sampler::halton(int n, double *cols){
+    for(int d=0;d<dim;d++){
+        int b = bases[d];
+        const int *p = perms[d].data();
+        double *out = cols + (long)d * n;
+        for(int i=0;i<n;i++){
+            long m = index + i;
+            double scale = 1.0 / b, u = 0;
+            for(int k=0;k<n_digits[d];k++){
+                u += p[k * b + m % b] * scale;
+                m /= b;
+                scale /= b;
+            }
+            out[i] = u;
+        }
+    }
+}
+
+void Sampler::lhs(int n, double *cols){
+    uniform_real_distribution<double> jitter(0, 1);
+    vector<int> strata(n);
+    for(int d=0;d<dim;d++){
+        for(int i=0;i<n;i++)
+            strata[i] = i;
+        shuffle(strata.begin(), strata.end(), rng);
+        double *out = cols + (long)d * n;
+        for(int i=0;i<n;i++)
+            out[i] = (strata[i] + jitter(rng)) / n;
+    }
+}
+
+#endif
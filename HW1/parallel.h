@@ -0,0 +1,251 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include<thread>
+#include<vector>
+#include<string>
+#include<functional>
+#include<fstream>
+#include<iostream>
+#include<iomanip>
+#include<algorithm>
+#include<cstdio>
+#include<cstdint>
+#include<new>
+#include<sched.h>
+#include<dirent.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+using namespace std;
+
+// 預設的 thread 數: 機器上的 core 數.
+int default_threads(){
+    int n = thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// /sys/devices/system/node 的 NUMA 拓樸, 只保留這個 process 可以使用的 cpu.
+// 沒有 sysfs (或不是 NUMA 機器) 時視為一個 node.
+class NumaTopology{
+public:
+    vector<int> node_ids;           // kernel 的 node 編號.
+    vector<vector<int>> node_cpus;  // 每個 node 的 cpu, 只有記憶體的 node 為空.
+    vector<int> cpu_node;           // cpu -> node 的 index, 不在 affinity mask 中的為 -1.
+    vector<int> worker_order;       // 依 node 排好的 cpu, run_workers 依序分配.
+    NumaTopology();
+    int n_nodes(){ return node_cpus.size(); }
+    int worker_cpu(int w, int n_threads);
+    int worker_node(int w, int n_threads);
+    int node_index(int id);
+};
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+vector<int> parse_cpulist(string list){
+    vector<int> cpus;
+    size_t pos = 0;
+    while(pos < list.size()){
+        size_t comma = list.find(',', pos);
+        if(comma == string::npos)
+            comma = list.size();
+        string range = list.substr(pos, comma - pos);
+        int lo, hi;
+        if(sscanf(range.c_str(), "%d-%d", &lo, &hi) == 2)
+            for(int c=lo;c<=hi;c++)
+                cpus.push_back(c);
+        else if(sscanf(range.c_str(), "%d", &lo) == 1)
+            cpus.push_back(lo);
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+NumaTopology::NumaTopology(){
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        for(int c=0;c<default_threads();c++)
+            CPU_SET(c, &allowed);
+
+    vector<int> ids;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if(dir != NULL){
+        struct dirent *entry;
+        int id;
+        while((entry = readdir(dir)) != NULL)
+            if(sscanf(entry->d_name, "node%d", &id) == 1)
+                ids.push_back(id);
+        closedir(dir);
+    }
+    sort(ids.begin(), ids.end());
+    for(int id: ids){
+        ifstream in("/sys/devices/system/node/node" + to_string(id) + "/cpulist");
+        string list;
+        getline(in, list);
+        vector<int> cpus;
+        for(int c: parse_cpulist(list))
+            if(c < CPU_SETSIZE && CPU_ISSET(c, &allowed))
+                cpus.push_back(c);
+        node_ids.push_back(id);
+        node_cpus.push_back(cpus);
+    }
+    if(node_ids.empty()){
+        node_ids.push_back(0);
+        node_cpus.resize(1);
+        for(int c=0;c<CPU_SETSIZE;c++)
+            if(CPU_ISSET(c, &allowed))
+                node_cpus[0].push_back(c);
+    }
+    for(int k=0;k<n_nodes();k++)
+        for(int c: node_cpus[k]){
+            if(c >= (int)cpu_node.size())
+                cpu_node.resize(c + 1, -1);
+            cpu_node[c] = k;
+            worker_order.push_back(c);
+        }
+    if(worker_order.empty()){
+        worker_order.push_back(0);
+        cpu_node.assign(1, 0);
+    }
+}
+
+// n_threads 個 worker 平均分到所有 cpu, 相鄰的 worker (相鄰的資料 slice) 在同一個 node.
+int NumaTopology::worker_cpu(int w, int n_threads){
+    return worker_order[(long)w * worker_order.size() / max(n_threads, 1) % worker_order.size()];
+}
+
+int NumaTopology::worker_node(int w, int n_threads){
+    return cpu_node[worker_cpu(w, n_threads)];
+}
+
+int NumaTopology::node_index(int id){
+    for(int k=0;k<n_nodes();k++)
+        if(node_ids[k] == id)
+            return k;
+    return -1;
+}
+
+NumaTopology &numa_topology(){
+    static NumaTopology topology;
+    return topology;
+}
+
+// true 時 run_workers 把 worker w 固定在 numa_topology().worker_cpu(w, n_threads),
+// 配合 first_touch() 讓每個 worker 的資料 slice 放在自己的 node 上.
+bool pin_workers = false;
+
+void pin_to_cpu(int cpu){
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+// 開 n_threads 個 thread 執行 fn(worker_id), 等全部結束才返回.
+void run_workers(int n_threads, function<void(int)> fn){
+    cpu_set_t saved;
+    if(pin_workers)
+        sched_getaffinity(0, sizeof(saved), &saved);
+    auto body = [&](int w){
+        if(pin_workers)
+            pin_to_cpu(numa_topology().worker_cpu(w, n_threads));
+        fn(w);
+    };
+    vector<thread> threads;
+    for(int w=1;w<n_threads;w++)
+        threads.emplace_back(body, w);
+    body(0);
+    for(thread &t: threads)
+        t.join();
+    if(pin_workers)     // worker 0 是呼叫者自己, 恢復原本的 affinity.
+        sched_setaffinity(0, sizeof(saved), &saved);
+}
+
+// 把 n 個元素平均切給 n_threads 個 worker, 回傳 worker w 的 [begin, end).
+pair<long, long> worker_slice(long n, int w, int n_threads){
+    return {n * w / n_threads, n * (w + 1) / n_threads};
+}
+
+// 配置但不碰任何 page, 由 first_touch() 或 worker 自己第一次寫入時決定 page 放在哪個 node.
+// (vector / new 會在呼叫的 thread 裡先清為 0, 所有 page 都落在同一個 node.)
+template<class T>
+T *alloc_untouched(size_t n){
+    void *p = mmap(NULL, max(n, (size_t)1) * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED)
+        throw bad_alloc();
+    return (T*)p;
+}
+
+template<class T>
+void free_untouched(T *p, size_t n){
+    munmap(p, max(n, (size_t)1) * sizeof(T));
+}
+
+// 每個 worker 把自己的 slice 初始化為 T(), 之後以相同的 worker_slice 切法存取就是 local memory.
+template<class T>
+void first_touch(T *p, long n, int n_threads){
+    run_workers(n_threads, [&](int w){
+        pair<long, long> s = worker_slice(n, w, n_threads);
+        for(long i=s.first;i<s.second;i++)
+            new(p + i) T();
+    });
+}
+
+// [p, p + bytes) 每個 page 所在的 node, 與依 worker_slice 切給該 worker 的 node 比較.
+struct PlacementStats{
+    long pages = 0, local = 0, remote = 0, missing = 0;   // missing: 還沒配置的 page.
+    vector<long> node_pages;        // 每個 node 上的 page 數, 順序同 NumaTopology::node_ids.
+};
+
+PlacementStats placement_stats(const void *p, size_t bytes, int n_threads){
+    PlacementStats stats;
+    NumaTopology &topo = numa_topology();
+    stats.node_pages.assign(topo.n_nodes(), 0);
+    long page = sysconf(_SC_PAGESIZE);
+    char *begin = (char*)((uintptr_t)p / page * page), *end = (char*)p + bytes;
+    long n_pages = (end - begin + page - 1) / page;
+    vector<void*> pages(n_pages);
+    vector<int> status(n_pages, -1);
+    for(long i=0;i<n_pages;i++)
+        pages[i] = begin + i * page;
+    // move_pages 的 nodes 為 NULL 時只查詢, 不移動.
+    if(n_pages > 0 && syscall(SYS_move_pages, 0, (unsigned long)n_pages, pages.data(), NULL, status.data(), 0) != 0)
+        status.assign(n_pages, -1);
+
+    for(long i=0;i<n_pages;i++){
+        stats.pages++;
+        int k = (status[i] >= 0) ? topo.node_index(status[i]) : -1;
+        if(k < 0){
+            stats.missing++;
+            continue;
+        }
+        stats.node_pages[k]++;
+        // page 開頭所屬的 slice.
+        long offset = max((long)((char*)pages[i] - (char*)p), 0L);
+        int w = min((long)n_threads - 1, offset * n_threads / max((long)bytes, 1L));
+        if(k == topo.worker_node(w, n_threads))
+            stats.local++;
+        else
+            stats.remote++;
+    }
+    return stats;
+}
+
+// 與其他程式相同的表格格式.
+void print_placement(PlacementStats &stats, int n_threads){
+    NumaTopology &topo = numa_topology();
+    cout<<"|numa nodes      | "<<topo.n_nodes()<<"|\n";
+    cout<<"|pinned workers  | "<<(pin_workers ? n_threads : 0)<<"|\n";
+    cout<<"|worker cpus     | ";
+    for(int w=0;w<n_threads;w++)
+        cout<<(w ? " " : "")<<topo.worker_cpu(w, n_threads);
+    cout<<"|\n";
+    cout<<"|pages local / remote / missing | "<<stats.local<<" / "<<stats.remote<<" / "<<stats.missing<<"|\n";
+    cout<<"|pages per node  | ";
+    for(int k=0;k<topo.n_nodes();k++)
+        cout<<(k ? " " : "")<<"node"<<topo.node_ids[k]<<":"<<stats.node_pages[k];
+    cout<<"|\n";
+    if(stats.pages > stats.missing)
+        cout<<"|local page ratio| "<<setprecision(4)<<(double)stats.local / (stats.pages - stats.missing)<<"|\n";
+}
+
+#endif
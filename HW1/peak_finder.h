@@ -0,0 +1,154 @@
+#ifndef PEAK_FINDER_H
+#define PEAK_FINDER_H
+#include<cmath>
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<functional>
+#include<unordered_map>
+using namespace std;
+
+// 從最後 (或 archive 裡) 的 population 找出多個山峰:
+//   1. 把點合併到邊長 eps / 4 的小格子, 每格記錄點數與 fitness 最好的點,
+//      收斂後大量重複的點因此只剩少數幾個帶權重的點;
+//   2. 以 k-d tree 對帶權重的點做 DBSCAN (eps 內權重 >= min_pts 為 core);
+//   3. 每個 cluster 回報 fitness 最好的點與 basin 大小 (原始點數).
+// 合併造成的距離誤差最多 eps / 4 * sqrt(2).
+
+struct Peak{
+    double x1, x2, fitness;
+    int basin_size;
+};
+
+// 2-D k-d tree, 以 nth_element 建在 index 陣列上 (implicit tree).
+class KdTree2{
+public:
+    KdTree2(const vector<double> &xs, const vector<double> &ys);
+    void radius_query(double x, double y, double r, const function<void(int)> &visit);
+private:
+    const vector<double> &xs, &ys;
+    vector<int> idx;
+    void build(int lo, int hi, int axis);
+    void query(int lo, int hi, int axis, double x, double y, double r, const function<void(int)> &visit);
+};
+
+KdTree2::KdTree2(const vector<double> &xs, const vector<double> &ys): xs(xs), ys(ys){
+    idx.resize(xs.size());
+    for(int i=0;i<(int)idx.size();i++)
+        idx[i] = i;
+    build(0, idx.size(), 0);
+}
+
+void KdTree2::build(int lo, int hi, int axis){
+    if(hi - lo <= 1)
+        return;
+    int mid = (lo + hi) / 2;
+    const vector<double> &key = axis ? ys : xs;
+    nth_element(idx.begin() + lo, idx.begin() + mid, idx.begin() + hi,
+                [&key](int a, int b){ return key[a] < key[b]; });
+    build(lo, mid, !axis);
+    build(mid + 1, hi, !axis);
+}
+
+void KdTree2::query(int lo, int hi, int axis, double x, double y, double r, const function<void(int)> &visit){
+    if(lo >= hi)
+        return;
+    int mid = (lo + hi) / 2, p = idx[mid];
+    double dx = xs[p] - x, dy = ys[p] - y;
+    if(dx * dx + dy * dy <= r * r)
+        visit(p);
+    double diff = axis ? dy : dx;
+    if(diff >= -r)
+        query(lo, mid, !axis, x, y, r, visit);
+    if(diff <= r)
+        query(mid + 1, hi, !axis, x, y, r, visit);
+}
+
+void KdTree2::radius_query(double x, double y, double r, const function<void(int)> &visit){
+    query(0, idx.size(), 0, x, y, r, visit);
+}
+
+// 回傳依 fitness 排序 (最好的在前) 的山峰.
+vector<Peak> find_peaks(const vector<double> &x1, const vector<double> &x2, const vector<double> &fitness,
+                        double eps, int min_pts, string mode){
+    auto better = [&mode](double a, double b){ return (mode == "max") ? a > b : a < b; };
+    int n = fitness.size();
+    vector<Peak> peaks;
+    if(n == 0)
+        return peaks;
+
+    // 1. 合併到小格子.
+    double h = eps / 4;
+    double x_min = *min_element(x1.begin(), x1.end()), y_min = *min_element(x2.begin(), x2.end());
+    unordered_map<unsigned long long, int> grid;
+    grid.reserve(min(n, 1 << 20));
+    vector<double> gx, gy, gf;
+    vector<int> weight;
+    for(int i=0;i<n;i++){
+        unsigned long long key = (unsigned long long)((x1[i] - x_min) / h) << 32 |
+                                 (unsigned long long)((x2[i] - y_min) / h);
+        auto it = grid.find(key);
+        if(it == grid.end()){
+            grid[key] = gf.size();
+            gx.push_back(x1[i]);
+            gy.push_back(x2[i]);
+            gf.push_back(fitness[i]);
+            weight.push_back(1);
+            continue;
+        }
+        int g = it->second;
+        weight[g]++;
+        if(better(fitness[i], gf[g])){
+            gx[g] = x1[i];
+            gy[g] = x2[i];
+            gf[g] = fitness[i];
+        }
+    }
+
+    // 2. DBSCAN.
+    int m = gf.size();
+    KdTree2 tree(gx, gy);
+    vector<int> label(m, -2);   // -2: 未處理, -1: noise, >= 0: cluster 編號.
+    vector<int> neighbors, queue;
+    auto region = [&](int p){
+        neighbors.clear();
+        int total = 0;
+        tree.radius_query(gx[p], gy[p], eps, [&](int q){
+            neighbors.push_back(q);
+            total += weight[q];
+        });
+        return total;
+    };
+    for(int p=0;p<m;p++){
+        if(label[p] != -2)
+            continue;
+        if(region(p) < min_pts){
+            label[p] = -1;
+            continue;
+        }
+        // 3. 新的 cluster, 邊擴展邊記錄山峰與 basin 大小.
+        int c = peaks.size();
+        peaks.push_back({gx[p], gy[p], gf[p], 0});
+        label[p] = c;
+        queue.assign(1, p);
+        for(int k=0;k<(int)queue.size();k++){
+            int q = queue[k];
+            peaks[c].basin_size += weight[q];
+            if(better(gf[q], peaks[c].fitness))
+                peaks[c] = {gx[q], gy[q], gf[q], peaks[c].basin_size};
+            if(q != p && region(q) < min_pts)
+                continue;   // border point, 不再擴展.
+            for(int r: neighbors){
+                if(label[r] >= 0)
+                    continue;
+                label[r] = c;
+                queue.push_back(r);
+            }
+        }
+    }
+
+    sort(peaks.begin(), peaks.end(), [&](const Peak &a, const Peak &b){ return better(a.fitness, b.fitness); });
+    return peaks;
+}
+
+#endif
@@ -0,0 +1,696 @@
+#define PY_SSIZE_T_CLEAN
+#include<Python.h>
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<vector>
+#include<climits>
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<random>
+#include<cfloat>
+#include"ga_util.h"
+#include"expr_vm.h"
+#include"dist_eval.h"
+#include"parallel.h"
+#include"elite_archive.h"
+#include"rate_control.h"
+#include"anytime.h"
+#include"surrogate.h"
+#include"peak_finder.h"
+#include"local_search.h"
+#include"low_discrepancy.h"
+using namespace std;
+
+// Python module pyga: 直接使用 C++ 的四個 solver.
+//   import pyga, numpy as np
+//   ga = pyga.GAFloat(max_iter=2000, expression="x1 * sin(x2)", min_bound=-1, max_bound=2)
+//   ga.run("max", 5)                       # 執行期間釋放 GIL, GA 每個物件只能 run 一次
+//   pop = np.asarray(ga.population)        # (population_size, 3) 的 [x1, x2, fitness], 不複製
+// population 等屬性回傳支援 buffer protocol 的 pyga.Buffer, 直接指向 solver 內部的 vector.
+// 還有 view 存在時 run() 會丟出 BufferError, 避免 vector 重新配置後 view 指到已釋放的記憶體.
+
+// 每個 solver 各自有 struct cell, 分別放進不同的 namespace.
+#define GA_NO_MAIN
+namespace ga_float_ns{
+#include"ga_float.cpp"
+}
+namespace ga_binary_ns{
+#include"ga_binary_string.cpp"
+}
+namespace hill_climbing_ns{
+#include"hill_climbing.cpp"
+}
+namespace anneling_ns{
+#include"anneling.cpp"
+}
+
+// 所有 solver 物件共用的開頭.
+struct SolverObject{
+    PyObject_HEAD
+    Py_ssize_t exports;     // 目前還存在的 buffer view 數量.
+    bool ready;             // __init__ 成功, solver 已建立.
+    bool running;           // run() 釋放 GIL 執行中.
+    bool finished;          // 已經 run 過. GA 的 population 只能初始化一次, 再跑要建立新的物件.
+    bool rerun;             // HillClimbing / Anneling: run() 可以重複呼叫, 每次從新的起點開始 (multi-start).
+    ExprVM *expr;
+    RateController *rate_control;
+};
+
+// buffer view 的描述: 最多 2 維, strides 以 byte 為單位.
+struct BufferSpec{
+    void *buf;
+    const char *format;
+    Py_ssize_t itemsize;
+    int ndim;
+    Py_ssize_t shape[2], strides[2];
+};
+
+typedef bool (*ViewFunc)(SolverObject *owner, int field, BufferSpec &spec);
+
+struct BufferObject{
+    PyObject_HEAD
+    SolverObject *owner;
+    int field;
+    ViewFunc view;
+    BufferSpec spec;
+};
+
+static int Buffer_getbuffer(BufferObject *self, Py_buffer *view, int flags){
+    if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE){
+        PyErr_SetString(PyExc_BufferError, "solver buffers are read-only");
+        return -1;
+    }
+    if(self->owner->running){
+        PyErr_SetString(PyExc_BufferError, "solver is running");
+        return -1;
+    }
+    if(!self->view(self->owner, self->field, self->spec)){
+        PyErr_SetString(PyExc_BufferError, "buffer is not available");
+        return -1;
+    }
+    BufferSpec &spec = self->spec;
+    view->obj = (PyObject*)self;
+    Py_INCREF(self);
+    view->buf = spec.buf;
+    view->len = spec.itemsize;
+    for(int d=0;d<spec.ndim;d++)
+        view->len *= spec.shape[d];
+    view->readonly = 1;
+    view->itemsize = spec.itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*)spec.format : NULL;
+    view->ndim = spec.ndim;
+    view->shape = spec.shape;
+    view->strides = spec.strides;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    self->owner->exports++;
+    return 0;
+}
+
+static void Buffer_releasebuffer(BufferObject *self, Py_buffer *){
+    self->owner->exports--;
+}
+
+static void Buffer_dealloc(BufferObject *self){
+    Py_DECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyBufferProcs Buffer_as_buffer = {
+    (getbufferproc)Buffer_getbuffer,
+    (releasebufferproc)Buffer_releasebuffer,
+};
+
+static PyTypeObject BufferType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyga.Buffer",
+};
+
+static bool check_ready(SolverObject *self){
+    if(!self->ready)
+        PyErr_SetString(PyExc_RuntimeError, "solver is not initialized");
+    return self->ready;
+}
+
+static PyObject *make_buffer(SolverObject *owner, int field, ViewFunc view){
+    if(!check_ready(owner))
+        return NULL;
+    BufferObject *self = PyObject_New(BufferObject, &BufferType);
+    if(self == NULL)
+        return NULL;
+    Py_INCREF(owner);
+    self->owner = owner;
+    self->field = field;
+    self->view = view;
+    return (PyObject*)self;
+}
+
+// vector<cell> (x1, x2, fitness 都是 double) 當作 (n, 3) 的 double 陣列.
+template<class Cell>
+static bool cell_view(vector<Cell> &cells, BufferSpec &spec){
+    static_assert(sizeof(Cell) == 3 * sizeof(double), "cell must be three doubles");
+    spec.buf = cells.data();
+    spec.format = "d";
+    spec.itemsize = sizeof(double);
+    spec.ndim = 2;
+    spec.shape[0] = cells.size();
+    spec.shape[1] = 3;
+    spec.strides[0] = sizeof(Cell);
+    spec.strides[1] = sizeof(double);
+    return true;
+}
+
+static bool int_view(vector<int> &values, BufferSpec &spec){
+    spec.buf = values.data();
+    spec.format = "i";
+    spec.itemsize = sizeof(int);
+    spec.ndim = 1;
+    spec.shape[0] = values.size();
+    spec.strides[0] = sizeof(int);
+    return true;
+}
+
+// run() 前的檢查: 不能同時執行, 也不能有 view 還指向會被改動的 vector.
+static bool begin_run(SolverObject *self){
+    if(!check_ready(self))
+        return false;
+    if(self->running){
+        PyErr_SetString(PyExc_RuntimeError, "solver is already running");
+        return false;
+    }
+    if(self->finished && !self->rerun){
+        PyErr_SetString(PyExc_RuntimeError, "solver has already run, create a new one");
+        return false;
+    }
+    if(self->exports > 0){
+        PyErr_SetString(PyExc_BufferError, "release all views of this solver before run()");
+        return false;
+    }
+    self->running = true;
+    return true;
+}
+
+// 建立 expression, 失敗時把 runtime_error 轉成 ValueError.
+static bool set_expression(SolverObject *self, const char *src){
+    if(src == NULL)
+        return true;
+    try{
+        self->expr = new ExprVM(src);
+    }catch(const exception &e){
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return false;
+    }
+    return true;
+}
+
+// adapt 為 None 時維持固定的 p_crossover / p_mutation.
+static bool set_rate_control(SolverObject *self, const char *rule){
+    if(rule == NULL)
+        return true;
+    try{
+        self->rate_control = new RateController(rule);
+    }catch(const exception &e){
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return false;
+    }
+    return true;
+}
+
+// 每個 generation 一個 (iter, p_crossover, p_mutation, n_crossover, n_mutation, win_crossover, win_mutation).
+static PyObject *rate_history(SolverObject *self){
+    if(!check_ready(self))
+        return NULL;
+    if(self->running){
+        PyErr_SetString(PyExc_RuntimeError, "solver is running");
+        return NULL;
+    }
+    if(self->rate_control == NULL)
+        return PyList_New(0);
+    vector<RateRecord> &history = self->rate_control->history;
+    PyObject *list = PyList_New(history.size());
+    if(list == NULL)
+        return NULL;
+    for(int i=0;i<(int)history.size();i++){
+        RateRecord &r = history[i];
+        PyObject *item = Py_BuildValue("(iddiiii)", r.iter, (double)r.p_crossover, (double)r.p_mutation,
+                                       r.n_crossover, r.n_mutation, r.win_crossover, r.win_mutation);
+        if(item == NULL){
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+static bool check_mode(const char *mode){
+    if(strcmp(mode, "max") == 0 || strcmp(mode, "min") == 0)
+        return true;
+    PyErr_SetString(PyExc_ValueError, "mode must be 'max' or 'min'");
+    return false;
+}
+
+// 釋放 GIL 執行 body, 例外轉成 Python 的 RuntimeError.
+template<class F>
+static bool run_nogil(SolverObject *self, F body){
+    string error;
+    Py_BEGIN_ALLOW_THREADS
+    try{
+        body();
+    }catch(const exception &e){
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    self->running = false;
+    self->finished = true;
+    if(!error.empty()){
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+static PyObject *cell_tuple(double x1, double x2, double fitness){
+    return Py_BuildValue("(ddd)", x1, x2, fitness);
+}
+
+// ----- GAFloat -----
+
+struct GAFloatObject: SolverObject{
+    ga_float_ns::GAFloat *solver;
+};
+
+enum{ GA_FLOAT_POPULATION, GA_FLOAT_BEST_GENES };
+
+static bool GAFloat_view(SolverObject *owner, int field, BufferSpec &spec){
+    ga_float_ns::GAFloat *ga = ((GAFloatObject*)owner)->solver;
+    if(field == GA_FLOAT_POPULATION)
+        return cell_view(ga->population, spec);
+    return int_view(ga->best_gene_list, spec);
+}
+
+static int GAFloat_init(GAFloatObject *self, PyObject *args, PyObject *kwds){
+    static const char *kwlist[] = {"max_iter", "population_size", "min_bound", "max_bound", "precision",
+                                   "p_mutation", "p_crossover", "elite_size", "expression", "adapt", NULL};
+    int max_iter = 10000, population_size = 50, elite_size = 2;
+    float min_bound = 0, max_bound = 1, precision = 0.0001, p_mutation = 0.01, p_crossover = 0.25;
+    const char *expression = NULL, *adapt = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|iifffffizz", (char**)kwlist, &max_iter, &population_size,
+                                    &min_bound, &max_bound, &precision, &p_mutation, &p_crossover,
+                                    &elite_size, &expression, &adapt))
+        return -1;
+    if(self->solver != NULL){
+        PyErr_SetString(PyExc_RuntimeError, "GAFloat is already initialized");
+        return -1;
+    }
+    if(!set_expression(self, expression) || !set_rate_control(self, adapt))
+        return -1;
+    self->solver = new ga_float_ns::GAFloat(max_iter, population_size, min_bound, max_bound, precision, p_mutation, p_crossover);
+    self->solver->fitness_expr = self->expr;
+    self->solver->elite_size = elite_size;
+    self->solver->rate_control = self->rate_control;
+    self->ready = true;
+    return 0;
+}
+
+static PyObject *GAFloat_run(GAFloatObject *self, PyObject *args){
+    const char *mode = "max";
+    int times = 5;
+    if(!PyArg_ParseTuple(args, "|si", &mode, &times) || !check_mode(mode) || !begin_run(self))
+        return NULL;
+    string m = mode;
+    ga_float_ns::GAFloat *ga = self->solver;
+    if(!run_nogil(self, [&](){ ga->run(m, times); }))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *GAFloat_get_population(GAFloatObject *self, void *){
+    return make_buffer(self, GA_FLOAT_POPULATION, GAFloat_view);
+}
+
+static PyObject *GAFloat_get_best_gene_list(GAFloatObject *self, void *){
+    return make_buffer(self, GA_FLOAT_BEST_GENES, GAFloat_view);
+}
+
+static PyObject *GAFloat_get_best(GAFloatObject *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    ga_float_ns::cell &best = self->solver->best_cell;
+    return cell_tuple(best.x1, best.x2, best.fitness);
+}
+
+static PyObject *GAFloat_get_best_iter(GAFloatObject *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    return PyLong_FromLong(self->solver->best_iter);
+}
+
+static PyObject *GAFloat_rate_history(GAFloatObject *self, PyObject *){
+    return rate_history(self);
+}
+
+static PyMethodDef GAFloat_methods[] = {
+    {"rate_history", (PyCFunction)GAFloat_rate_history, METH_NOARGS, "per-generation operator rates and success counts (adapt mode)."},
+    {"run", (PyCFunction)GAFloat_run, METH_VARARGS, "run(mode='max', times=5): run the GA without holding the GIL. Can be called once per object."},
+    {NULL}
+};
+
+static PyGetSetDef GAFloat_getset[] = {
+    {"population", (getter)GAFloat_get_population, NULL, "(population_size, 3) view of [x1, x2, fitness]."},
+    {"best_gene_list", (getter)GAFloat_get_best_gene_list, NULL, "index of the best cell in each generation."},
+    {"best", (getter)GAFloat_get_best, NULL, "(x1, x2, fitness) of the best cell."},
+    {"best_iter", (getter)GAFloat_get_best_iter, NULL, "generation in which the best cell was found."},
+    {NULL}
+};
+
+// ----- GABinaryString -----
+
+// precision 由 Python 決定, 所以用 runtime 長度的版本.
+struct GABinaryObject: SolverObject{
+    ga_binary_ns::GABinaryString<0> *solver;
+};
+
+enum{ GA_BINARY_FITNESS, GA_BINARY_BEST_GENES };
+
+// fitness 以 stride 為 sizeof(cell) 的 view 提供.
+static bool GABinary_view(SolverObject *owner, int field, BufferSpec &spec){
+    ga_binary_ns::GABinaryString<0> *ga = ((GABinaryObject*)owner)->solver;
+    if(field == GA_BINARY_BEST_GENES)
+        return int_view(ga->best_gene_list, spec);
+    if(ga->population.empty())
+        return false;
+    spec.buf = &ga->population[0].fitness;
+    spec.format = "d";
+    spec.itemsize = sizeof(double);
+    spec.ndim = 1;
+    spec.shape[0] = ga->population.size();
+    spec.strides[0] = sizeof(ga_binary_ns::cell);
+    return true;
+}
+
+static int GABinary_init(GABinaryObject *self, PyObject *args, PyObject *kwds){
+    static const char *kwlist[] = {"max_iter", "population_size", "min_bound", "max_bound", "precision",
+                                   "p_mutation", "p_crossover", "encoding", "elite_size", "expression", "adapt", NULL};
+    int max_iter = 10000, population_size = 50, elite_size = 2;
+    float min_bound = 0, max_bound = 1, precision = 0.0001, p_mutation = 0.01, p_crossover = 0.25;
+    const char *encoding = "gray", *expression = NULL, *adapt = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|iifffffsizz", (char**)kwlist, &max_iter, &population_size,
+                                    &min_bound, &max_bound, &precision, &p_mutation, &p_crossover,
+                                    &encoding, &elite_size, &expression, &adapt))
+        return -1;
+    if(self->solver != NULL){
+        PyErr_SetString(PyExc_RuntimeError, "GABinaryString is already initialized");
+        return -1;
+    }
+    if(strcmp(encoding, "binary") != 0 && strcmp(encoding, "gray") != 0){
+        PyErr_SetString(PyExc_ValueError, "encoding must be 'binary' or 'gray'");
+        return -1;
+    }
+    if(!set_expression(self, expression) || !set_rate_control(self, adapt))
+        return -1;
+    self->solver = new ga_binary_ns::GABinaryString<0>(max_iter, population_size, min_bound, max_bound, precision, p_mutation, p_crossover, encoding);
+    self->solver->fitness_expr = self->expr;
+    self->solver->elite_size = elite_size;
+    self->solver->rate_control = self->rate_control;
+    self->ready = true;
+    return 0;
+}
+
+static PyObject *GABinary_run(GABinaryObject *self, PyObject *args){
+    const char *mode = "max";
+    int times = 5;
+    if(!PyArg_ParseTuple(args, "|si", &mode, &times) || !check_mode(mode) || !begin_run(self))
+        return NULL;
+    string m = mode;
+    ga_binary_ns::GABinaryString<0> *ga = self->solver;
+    if(!run_nogil(self, [&](){ ga->run(m, times); }))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+// 解碼後的 (x1, x2) 是計算出來的值, 只能複製成 list.
+static PyObject *GABinary_decoded(GABinaryObject *self, PyObject *){
+    if(!check_ready(self))
+        return NULL;
+    if(self->running){
+        PyErr_SetString(PyExc_RuntimeError, "solver is running");
+        return NULL;
+    }
+    ga_binary_ns::GABinaryString<0> *ga = self->solver;
+    PyObject *list = PyList_New(ga->population.size());
+    if(list == NULL)
+        return NULL;
+    for(int i=0;i<(int)ga->population.size();i++){
+        ga_binary_ns::cell &node = ga->population[i];
+        PyObject *item = cell_tuple(ga->cal_decimal(node.x1), ga->cal_decimal(node.x2), node.fitness);
+        if(item == NULL){
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+static PyObject *GABinary_get_fitness(GABinaryObject *self, void *){
+    return make_buffer(self, GA_BINARY_FITNESS, GABinary_view);
+}
+
+static PyObject *GABinary_get_best_gene_list(GABinaryObject *self, void *){
+    return make_buffer(self, GA_BINARY_BEST_GENES, GABinary_view);
+}
+
+static PyObject *GABinary_get_best(GABinaryObject *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    ga_binary_ns::GABinaryString<0> *ga = self->solver;
+    if(ga->cur_iter == 0)
+        Py_RETURN_NONE;
+    return cell_tuple(ga->cal_decimal(ga->best_cell.x1), ga->cal_decimal(ga->best_cell.x2), ga->best_cell.fitness);
+}
+
+static PyObject *GABinary_get_best_iter(GABinaryObject *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    return PyLong_FromLong(self->solver->best_iter);
+}
+
+static PyObject *GABinary_rate_history(GABinaryObject *self, PyObject *){
+    return rate_history(self);
+}
+
+static PyMethodDef GABinary_methods[] = {
+    {"rate_history", (PyCFunction)GABinary_rate_history, METH_NOARGS, "per-generation operator rates and success counts (adapt mode)."},
+    {"run", (PyCFunction)GABinary_run, METH_VARARGS, "run(mode='max', times=5): run the GA without holding the GIL. Can be called once per object."},
+    {"decoded", (PyCFunction)GABinary_decoded, METH_NOARGS, "list of decoded (x1, x2, fitness) for the population."},
+    {NULL}
+};
+
+static PyGetSetDef GABinary_getset[] = {
+    {"fitness", (getter)GABinary_get_fitness, NULL, "strided view of the population fitness."},
+    {"best_gene_list", (getter)GABinary_get_best_gene_list, NULL, "index of the best cell in each generation."},
+    {"best", (getter)GABinary_get_best, NULL, "decoded (x1, x2, fitness) of the best cell."},
+    {"best_iter", (getter)GABinary_get_best_iter, NULL, "generation in which the best cell was found."},
+    {NULL}
+};
+
+// ----- HillClimbing / Anneling -----
+// 兩者的介面相同, 以 template 共用; run() 回傳最好的 cell, best_node_list 為每個 iteration 的最佳 cell.
+
+template<class Solver>
+struct LocalObject: SolverObject{
+    Solver *solver;
+};
+
+template<class Solver>
+static bool Local_view(SolverObject *owner, int, BufferSpec &spec){
+    return cell_view(((LocalObject<Solver>*)owner)->solver->best_node_list, spec);
+}
+
+static int HillClimbing_init(LocalObject<hill_climbing_ns::HillClimbing> *self, PyObject *args, PyObject *kwds){
+    static const char *kwlist[] = {"max_iter", "min_bound", "max_bound", "precision", "expression", NULL};
+    int max_iter = 10000;
+    float min_bound = 0, max_bound = 1, precision = 0.0001;
+    const char *expression = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|ifffz", (char**)kwlist, &max_iter,
+                                    &min_bound, &max_bound, &precision, &expression))
+        return -1;
+    if(self->solver != NULL){
+        PyErr_SetString(PyExc_RuntimeError, "HillClimbing is already initialized");
+        return -1;
+    }
+    if(!set_expression(self, expression))
+        return -1;
+    self->solver = new hill_climbing_ns::HillClimbing(max_iter, min_bound, max_bound, precision);
+    self->solver->fitness_expr = self->expr;
+    self->rerun = true;
+    self->ready = true;
+    return 0;
+}
+
+static int Anneling_init(LocalObject<anneling_ns::Anneling> *self, PyObject *args, PyObject *kwds){
+    static const char *kwlist[] = {"max_iter", "min_bound", "max_bound", "precision", "temperature", "expression", NULL};
+    int max_iter = 10000;
+    float min_bound = 0, max_bound = 1, precision = 0.0001, temperature = 1000;
+    const char *expression = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|iffffz", (char**)kwlist, &max_iter,
+                                    &min_bound, &max_bound, &precision, &temperature, &expression))
+        return -1;
+    if(self->solver != NULL){
+        PyErr_SetString(PyExc_RuntimeError, "Anneling is already initialized");
+        return -1;
+    }
+    if(!set_expression(self, expression))
+        return -1;
+    self->solver = new anneling_ns::Anneling(max_iter, min_bound, max_bound, precision, temperature);
+    self->solver->fitness_expr = self->expr;
+    self->rerun = true;
+    self->ready = true;
+    return 0;
+}
+
+template<class Solver>
+static PyObject *Local_run(LocalObject<Solver> *self, PyObject *args){
+    const char *mode = "max";
+    if(!PyArg_ParseTuple(args, "|s", &mode) || !check_mode(mode) || !begin_run(self))
+        return NULL;
+    string m = mode;
+    Solver *solver = self->solver;
+    solver->best_node_list.clear();     // 只保留這一次 run 的紀錄, begin_run 已確認沒有 view.
+    auto best = solver->best_node;
+    if(!run_nogil(self, [&](){ best = solver->run(m); }))
+        return NULL;
+    return cell_tuple(best.x1, best.x2, best.fitness);
+}
+
+template<class Solver>
+static PyObject *Local_get_best_node_list(LocalObject<Solver> *self, void *){
+    return make_buffer(self, 0, Local_view<Solver>);
+}
+
+template<class Solver>
+static PyObject *Local_get_best(LocalObject<Solver> *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    auto &best = self->solver->best_node;
+    return cell_tuple(best.x1, best.x2, best.fitness);
+}
+
+template<class Solver>
+static PyObject *Local_get_best_iter(LocalObject<Solver> *self, void *){
+    if(!check_ready(self))
+        return NULL;
+    return PyLong_FromLong(self->solver->best_iter);
+}
+
+template<class Solver>
+struct LocalTable{
+    static PyMethodDef methods[];
+    static PyGetSetDef getset[];
+};
+
+template<class Solver>
+PyMethodDef LocalTable<Solver>::methods[] = {
+    {"run", (PyCFunction)Local_run<Solver>, METH_VARARGS, "run(mode='max'): search from a new random start without holding the GIL, returns (x1, x2, fitness). May be called repeatedly for multi-start."},
+    {NULL}
+};
+
+template<class Solver>
+PyGetSetDef LocalTable<Solver>::getset[] = {
+    {"best_node_list", (getter)Local_get_best_node_list<Solver>, NULL, "(max_iter, 3) view of the best cell in each iteration."},
+    {"best", (getter)Local_get_best<Solver>, NULL, "(x1, x2, fitness) of the best cell."},
+    {"best_iter", (getter)Local_get_best_iter<Solver>, NULL, "iteration in which the best cell was found."},
+    {NULL}
+};
+
+// ----- 型別與 module -----
+
+// solver 與 expression 都由 Python 物件擁有. Buffer 持有 owner 的 reference,
+// 所以 dealloc 時不會有 view 還指向 solver.
+template<class Object>
+static void Solver_dealloc(Object *self){
+    delete self->solver;
+    delete self->expr;
+    delete self->rate_control;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *Solver_new(PyTypeObject *type, PyObject *, PyObject *){
+    // tp_alloc 會把整個物件清成 0: exports = 0, ready = running = finished = rerun = false, 指標都是 NULL.
+    return type->tp_alloc(type, 0);
+}
+
+static PyTypeObject GAFloatType = {PyVarObject_HEAD_INIT(NULL, 0) "pyga.GAFloat"};
+static PyTypeObject GABinaryType = {PyVarObject_HEAD_INIT(NULL, 0) "pyga.GABinaryString"};
+static PyTypeObject HillClimbingType = {PyVarObject_HEAD_INIT(NULL, 0) "pyga.HillClimbing"};
+static PyTypeObject AnnelingType = {PyVarObject_HEAD_INIT(NULL, 0) "pyga.Anneling"};
+
+static void init_solver_type(PyTypeObject &type, Py_ssize_t size, destructor dealloc, initproc init,
+                             PyMethodDef *methods, PyGetSetDef *getset, const char *doc){
+    type.tp_basicsize = size;
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = Solver_new;
+    type.tp_init = init;
+    type.tp_dealloc = dealloc;
+    type.tp_methods = methods;
+    type.tp_getset = getset;
+    type.tp_doc = doc;
+}
+
+static PyObject *pyga_seed(PyObject *, PyObject *args){
+    unsigned int seed;
+    if(!PyArg_ParseTuple(args, "I", &seed))
+        return NULL;
+    srand(seed);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef pyga_methods[] = {
+    {"seed", pyga_seed, METH_VARARGS, "seed(n): seed the C rand() used by all solvers."},
+    {NULL}
+};
+
+static PyModuleDef pyga_module = {
+    PyModuleDef_HEAD_INIT, "pyga", "Python bindings for the HW1 solvers.", -1, pyga_methods,
+};
+
+PyMODINIT_FUNC PyInit_pyga(){
+    BufferType.tp_basicsize = sizeof(BufferObject);
+    BufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+    BufferType.tp_dealloc = (destructor)Buffer_dealloc;
+    BufferType.tp_as_buffer = &Buffer_as_buffer;
+    BufferType.tp_doc = "Read-only view of a solver's internal array; use memoryview() or numpy.asarray().";
+
+    typedef LocalObject<hill_climbing_ns::HillClimbing> HillObject;
+    typedef LocalObject<anneling_ns::Anneling> AnnealObject;
+    init_solver_type(GAFloatType, sizeof(GAFloatObject), (destructor)Solver_dealloc<GAFloatObject>,
+                     (initproc)GAFloat_init, GAFloat_methods, GAFloat_getset, "Real-valued GA.");
+    init_solver_type(GABinaryType, sizeof(GABinaryObject), (destructor)Solver_dealloc<GABinaryObject>,
+                     (initproc)GABinary_init, GABinary_methods, GABinary_getset, "Binary / gray coded GA.");
+    init_solver_type(HillClimbingType, sizeof(HillObject), (destructor)Solver_dealloc<HillObject>,
+                     (initproc)HillClimbing_init, LocalTable<hill_climbing_ns::HillClimbing>::methods,
+                     LocalTable<hill_climbing_ns::HillClimbing>::getset, "Hill climbing.");
+    init_solver_type(AnnelingType, sizeof(AnnealObject), (destructor)Solver_dealloc<AnnealObject>,
+                     (initproc)Anneling_init, LocalTable<anneling_ns::Anneling>::methods,
+                     LocalTable<anneling_ns::Anneling>::getset, "Simulated annealing.");
+
+    PyTypeObject *types[] = {&BufferType, &GAFloatType, &GABinaryType, &HillClimbingType, &AnnelingType};
+    for(PyTypeObject *type: types)
+        if(PyType_Ready(type) < 0)
+            return NULL;
+    PyObject *m = PyModule_Create(&pyga_module);
+    if(m == NULL)
+        return NULL;
+    PyModule_AddObject(m, "Buffer", (PyObject*)&BufferType);
+    PyModule_AddObject(m, "GAFloat", (PyObject*)&GAFloatType);
+    PyModule_AddObject(m, "GABinaryString", (PyObject*)&GABinaryType);
+    PyModule_AddObject(m, "HillClimbing", (PyObject*)&HillClimbingType);
+    PyModule_AddObject(m, "Anneling", (PyObject*)&AnnelingType);
+    for(PyTypeObject *type: types)
+        Py_INCREF(type);
+    return m;
+}
@@ -0,0 +1,123 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+#include<cstdio>
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<stdexcept>
+using namespace std;
+
+// 在 run 的過程中依照 operator 的成功率自動調整 p_crossover 與 p_mutation,
+// 取代以整個 grid 的完整 run 掃參數.
+// 每個 generation:
+//   select 之後 begin_generation() 記下每個位置 parent 的 fitness,
+//   crossover / mutation 以 mark() 標記改過哪些個體,
+//   evaluate 之後 end_generation() 統計每個 operator 產生的 offspring
+//   中比 parent 好的比例, 再依 rule 調整機率並記錄到 history.
+// rule:
+//   "success": 1/5th success rule, 成功率 > 1/5 時機率乘上 factor, 否則除以 factor.
+//   "pursuit": adaptive pursuit, quality 為成功率的指數平均, quality 最高的 operator
+//              的機率往 rate_max 移動, 其他往 rate_min 移動.
+// 同一個個體被兩個 operator 改過時兩者都計入.
+
+struct RateRecord{
+    int iter;
+    float p_crossover, p_mutation;
+    int n_crossover, n_mutation;        // 這個 generation 被各 operator 改過的個體數.
+    int win_crossover, win_mutation;    // 其中比 parent 好的個數.
+};
+
+class RateController{
+public:
+    enum{ CROSSOVER = 1, MUTATION = 2 };
+    string rule;
+    float rate_min[2] = {0.05, 0.001};  // {crossover, mutation} 的下限.
+    float rate_max[2] = {0.95, 0.1};    // mutation 是每個 gene 的機率, 上限較低.
+    double factor = 1.2;            // "success" 每個 generation 調整的倍率.
+    double alpha = 0.3;             // "pursuit" quality 的平均速度.
+    double beta = 0.1;              // "pursuit" 機率移動的速度.
+    double quality[2] = {0.2, 0.2};
+    vector<RateRecord> history;
+    RateController(string rule);
+    void mark(int idx, int op);
+    template<class Cell> void begin_generation(const vector<Cell> &population);
+    template<class Cell> void end_generation(const vector<Cell> &population, string mode, int iter,
+                                             float &p_crossover, float &p_mutation);
+    void save_history(string path);
+private:
+    vector<char> applied;
+    vector<double> parent_fitness;
+    void adapt(float &rate, int op, int n, int win, bool leader);
+};
+
+RateController::RateController(string rule){
+    if(rule != "success" && rule != "pursuit")
+        throw runtime_error("unknown rate control rule: " + rule);
+    this->rule = rule;
+}
+
+void RateController::mark(int idx, int op){
+    applied[idx] |= op;
+}
+
+template<class Cell>
+void RateController::begin_generation(const vector<Cell> &population){
+    applied.assign(population.size(), 0);
+    parent_fitness.resize(population.size());
+    for(int i=0;i<(int)population.size();i++)
+        parent_fitness[i] = population[i].fitness;
+}
+
+template<class Cell>
+void RateController::end_generation(const vector<Cell> &population, string mode, int iter,
+                                    float &p_crossover, float &p_mutation){
+    int n[2] = {0, 0}, win[2] = {0, 0};
+    for(int i=0;i<(int)population.size();i++){
+        if(!applied[i])
+            continue;
+        double f = population[i].fitness, parent = parent_fitness[i];
+        bool better = (mode == "max") ? f > parent : f < parent;
+        for(int k=0;k<2;k++){
+            if(!(applied[i] & (1 << k)))
+                continue;
+            n[k]++;
+            win[k] += better;
+        }
+    }
+    history.push_back({iter, p_crossover, p_mutation, n[0], n[1], win[0], win[1]});
+
+    // 沒有被使用的 operator 這個 generation 沒有資訊, quality 不變.
+    for(int k=0;k<2;k++)
+        if(n[k] > 0)
+            quality[k] += alpha * ((double)win[k] / n[k] - quality[k]);
+    int leader = (quality[0] >= quality[1]) ? 0 : 1;
+    adapt(p_crossover, 0, n[0], win[0], leader == 0);
+    adapt(p_mutation, 1, n[1], win[1], leader == 1);
+}
+
+void RateController::adapt(float &rate, int op, int n, int win, bool leader){
+    if(rule == "success"){
+        if(n == 0)
+            return;
+        rate = ((double)win / n > 0.2) ? rate * factor : rate / factor;
+    }
+    else{
+        float target = leader ? rate_max[op] : rate_min[op];
+        rate += beta * (target - rate);
+    }
+    rate = min(max(rate, rate_min[op]), rate_max[op]);
+}
+
+// CSV: iter,p_crossover,p_mutation,n_crossover,n_mutation,win_crossover,win_mutation
+void RateController::save_history(string path){
+    FILE *fp = fopen(path.c_str(), "w");
+    if(fp == NULL)
+        throw runtime_error("cannot write " + path);
+    fprintf(fp, "iter,p_crossover,p_mutation,n_crossover,n_mutation,win_crossover,win_mutation\n");
+    for(const RateRecord &r: history)
+        fprintf(fp, "%d,%g,%g,%d,%d,%d,%d\n", r.iter, r.p_crossover, r.p_mutation,
+                r.n_crossover, r.n_mutation, r.win_crossover, r.win_mutation);
+    fclose(fp);
+}
+
+#endif
@@ -0,0 +1,342 @@
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<cstring>
+#include<cstdint>
+#include<cfloat>
+#include<string>
+#include<vector>
+#include<thread>
+#include<chrono>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include"ga_util.h"
+#include"fitness.h"
+using namespace std;
+
+// Out-of-core GA: population 放在 memory-mapped 的檔案, 大小可以超過記憶體.
+// 每個 generation 由 parent 檔案串流產生 child 檔案, 一次只處理一個 chunk:
+//   Selection: chunked tournament, child chunk k 的 parent 都來自 parent chunk perm[k]
+//              (perm 每個 generation 重新打亂), 所以只需要一個 parent chunk 在記憶體中.
+//   Crossover: 與 GAFloat 一樣交換 x2, 對象取自 reservoir, 上一代以 reservoir sampling
+//              (Algorithm R) 均勻抽出的 reservoir_size 個個體, 讓基因能跨 chunk 流動.
+//   Mutation:  與 GAFloat 相同, 以 p_mutation 重新亂數產生一個座標.
+// 處理 chunk k 時另一個 thread 先讀取下一個 parent chunk (madvise + 逐 page 讀取),
+// 所以磁碟 I/O 與 evaluation 重疊. 用過的 parent chunk 以 MADV_DONTNEED 釋放.
+//
+// 檔案為 POPFILE_HEADER bytes 的 header 加上 rows 個 cell (x1, x2, fitness 各為 float64):
+//   np.memmap(path, dtype=[('x1', '<f8'), ('x2', '<f8'), ('fitness', '<f8')], mode='r', offset=256)
+const int POPFILE_HEADER = 256;
+
+struct PopFileHeader{
+    char magic[8];          // "GAPOP1"
+    uint32_t header_size;   // POPFILE_HEADER
+    uint32_t generation;
+    uint64_t rows;
+    double min_bound, max_bound;
+};
+
+static_assert(sizeof(PopFileHeader) <= POPFILE_HEADER, "header too large");
+
+struct cell{
+    double x1, x2;
+    double fitness;
+};
+
+class MappedPopulation{
+public:
+    string path;
+    long rows;
+    size_t bytes;
+    int fd;
+    char *map;
+    cell *cells;
+    MappedPopulation(string path, long rows);
+    ~MappedPopulation();
+    void prefetch(long begin, long end);
+    void release(long begin, long end);
+    PopFileHeader *header();
+private:
+    void page_range(long begin, long end, char *&lo, size_t &len);
+};
+
+MappedPopulation::MappedPopulation(string path, long rows){
+    this->path = path;
+    this->rows = rows;
+    bytes = POPFILE_HEADER + rows * sizeof(cell);
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0 || ftruncate(fd, bytes) < 0)
+        throw runtime_error("cannot create " + path);
+    map = (char*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+        throw runtime_error("mmap failed: " + path);
+    cells = (cell*)(map + POPFILE_HEADER);
+    PopFileHeader *head = header();
+    memset(head, 0, sizeof(PopFileHeader));
+    strcpy(head->magic, "GAPOP1");
+    head->header_size = POPFILE_HEADER;
+    head->rows = rows;
+}
+
+MappedPopulation::~MappedPopulation(){
+    munmap(map, bytes);
+    close(fd);
+}
+
+PopFileHeader *MappedPopulation::header(){
+    return (PopFileHeader*)map;
+}
+
+// cells[begin, end) 所在的 page.
+void MappedPopulation::page_range(long begin, long end, char *&lo, size_t &len){
+    long page = sysconf(_SC_PAGESIZE);
+    size_t first = (POPFILE_HEADER + begin * sizeof(cell)) / page * page;
+    size_t last = min(bytes, POPFILE_HEADER + end * sizeof(cell));
+    lo = map + first;
+    len = last - first;
+}
+
+// 在呼叫的 thread 中把 page 讀進來, 由 run() 放到另一個 thread 執行.
+void MappedPopulation::prefetch(long begin, long end){
+    char *lo;
+    size_t len;
+    page_range(begin, end, lo, len);
+    madvise(lo, len, MADV_WILLNEED);
+    long page = sysconf(_SC_PAGESIZE);
+    volatile char sink = 0;
+    for(size_t off=0;off<len;off+=page)
+        sink += lo[off];
+}
+
+void MappedPopulation::release(long begin, long end){
+    char *lo;
+    size_t len;
+    page_range(begin, end, lo, len);
+    madvise(lo, len, MADV_DONTNEED);
+}
+
+class StreamGA{
+public:
+    int max_iter, times;
+    long population_size, chunk_size;
+    float min_bound, max_bound, p_mutation, p_crossover;
+    BatchKernel fitness;
+    int reservoir_size = 4096;
+    vector<cell> reservoir, next_reservoir;
+    vector<double> cols, out;
+    cell best_cell;
+    int best_iter = 0;
+    long n_seen = 0;            // 這個 generation 已經交給 reservoir 的個體數.
+    long n_evals = 0;
+    double io_wait = 0, busy = 0;   // 等待 prefetch 與處理 chunk 的時間.
+    StreamStats gen_stats;      // 這個 generation 的 fitness.
+    StreamGA(int max_iter, long population_size, long chunk_size, float min_bound, float max_bound, float p_mutation, float p_crossover, BatchKernel fitness);
+    void initialize(MappedPopulation &pop, string mode);
+    void generation(MappedPopulation &parents, MappedPopulation &children, string mode, int iter);
+    void evaluate(cell *cells, const vector<long> &idx);
+    void offer(const cell &node, bool maximize, int iter);
+    void run(string dir, string mode);
+    double randfloat(float min, float max);
+};
+
+StreamGA::StreamGA(int max_iter, long population_size, long chunk_size, float min_bound, float max_bound, float p_mutation, float p_crossover, BatchKernel fitness){
+    this->max_iter = max_iter;
+    this->population_size = population_size;
+    this->chunk_size = min(chunk_size, population_size);
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    this->p_mutation = p_mutation;
+    this->p_crossover = p_crossover;
+    this->fitness = fitness;
+    this->times = 5;
+}
+
+double StreamGA::randfloat(float min, float max){
+    return (max - min) * rand() / RAND_MAX + min;
+}
+
+// 只算 idx 中的個體, 每次 4096 個轉成 column 給 batch kernel.
+void StreamGA::evaluate(cell *cells, const vector<long> &idx){
+    const long TILE = 4096;
+    cols.resize(2 * TILE);
+    out.resize(TILE);
+    for(long b=0;b<(long)idx.size();b+=TILE){
+        long m = min(TILE, (long)idx.size() - b);
+        for(long j=0;j<m;j++){
+            cols[j] = cells[idx[b + j]].x1;
+            cols[m + j] = cells[idx[b + j]].x2;
+        }
+        fitness(cols.data(), m, 2, out.data());
+        for(long j=0;j<m;j++)
+            cells[idx[b + j]].fitness = out[j];
+    }
+    n_evals += idx.size();
+}
+
+// 每個新的個體: 更新 best_cell, 統計, 以及下一代用的 reservoir (Algorithm R).
+void StreamGA::offer(const cell &node, bool maximize, int iter){
+    if(maximize ? node.fitness > best_cell.fitness : node.fitness < best_cell.fitness){
+        best_cell = node;
+        best_iter = iter;
+    }
+    gen_stats.add(node.fitness);
+    n_seen++;
+    if((long)next_reservoir.size() < reservoir_size)
+        next_reservoir.push_back(node);
+    else{
+        long j = ((long)rand() * ((long)RAND_MAX + 1) + rand()) % n_seen;
+        if(j < reservoir_size)
+            next_reservoir[j] = node;
+    }
+}
+
+void StreamGA::initialize(MappedPopulation &pop, string mode){
+    best_cell.fitness = (mode == "max") ? -DBL_MAX : DBL_MAX;
+    vector<long> idx;
+    for(long b=0;b<population_size;b+=chunk_size){
+        long e = min(b + chunk_size, population_size);
+        idx.clear();
+        for(long i=b;i<e;i++){
+            pop.cells[i].x1 = randfloat(min_bound, max_bound);
+            pop.cells[i].x2 = randfloat(min_bound, max_bound);
+            idx.push_back(i);
+        }
+        evaluate(pop.cells, idx);
+        for(long i=b;i<e;i++)
+            offer(pop.cells[i], mode == "max", 0);
+    }
+}
+
+void StreamGA::generation(MappedPopulation &parents, MappedPopulation &children, string mode, int iter){
+    long n_chunks = (population_size + chunk_size - 1) / chunk_size;
+    vector<long> perm(n_chunks);
+    for(long k=0;k<n_chunks;k++)
+        perm[k] = k;
+    for(long k=n_chunks-1;k>0;k--)
+        swap(perm[k], perm[rand() % (k + 1)]);
+
+    reservoir.swap(next_reservoir);
+    next_reservoir.clear();
+    n_seen = 0;
+    gen_stats = StreamStats();
+    cell elite = best_cell;
+    bool maximize = (mode == "max");
+
+    auto chunk_begin = [&](long k){ return k * chunk_size; };
+    auto chunk_end = [&](long k){ return min((k + 1) * chunk_size, population_size); };
+    thread loader([&](){ parents.prefetch(chunk_begin(perm[0]), chunk_end(perm[0])); });
+    vector<long> changed;
+    for(long k=0;k<n_chunks;k++){
+        auto t0 = chrono::steady_clock::now();
+        loader.join();
+        auto t1 = chrono::steady_clock::now();
+        io_wait += chrono::duration<double>(t1 - t0).count();
+        if(k + 1 < n_chunks)
+            loader = thread([&, k](){ parents.prefetch(chunk_begin(perm[k + 1]), chunk_end(perm[k + 1])); });
+
+        long pb = chunk_begin(perm[k]), pm = chunk_end(perm[k]) - pb;
+        long cb = chunk_begin(k), ce = chunk_end(k);
+        cell *pool = parents.cells + pb;
+        changed.clear();
+        for(long i=cb;i<ce;i++){
+            // Chunked tournament.
+            long select_idx = rand() % pm;
+            for(int j=0;j<times;j++){
+                long idx = rand() % pm;
+                if(maximize ? pool[idx].fitness > pool[select_idx].fitness : pool[idx].fitness < pool[select_idx].fitness)
+                    select_idx = idx;
+            }
+            cell node = pool[select_idx];
+            bool modified = false;
+            if((double)rand() / RAND_MAX < p_crossover){
+                node.x2 = reservoir[rand() % reservoir.size()].x2;
+                modified = true;
+            }
+            if((double)rand() / RAND_MAX < p_mutation){
+                node.x1 = randfloat(min_bound, max_bound);
+                modified = true;
+            }
+            if((double)rand() / RAND_MAX < p_mutation){
+                node.x2 = randfloat(min_bound, max_bound);
+                modified = true;
+            }
+            children.cells[i] = node;
+            if(modified)
+                changed.push_back(i);
+        }
+        // Elitism: 目前為止最好的個體放在第一個位置.
+        if(k == 0)
+            children.cells[0] = elite;
+        evaluate(children.cells, changed);
+        for(long i=cb;i<ce;i++)
+            offer(children.cells[i], maximize, iter);
+        parents.release(pb, pb + pm);
+        busy += chrono::duration<double>(chrono::steady_clock::now() - t1).count();
+    }
+    if(n_chunks == 0)
+        loader.join();
+    children.header()->generation = iter;
+}
+
+void StreamGA::run(string dir, string mode){
+    MappedPopulation a(dir + "/pop_a.bin", population_size), b(dir + "/pop_b.bin", population_size);
+    for(MappedPopulation *pop: {&a, &b}){
+        pop->header()->min_bound = min_bound;
+        pop->header()->max_bound = max_bound;
+    }
+    MappedPopulation *parents = &a, *children = &b;
+    auto start = chrono::steady_clock::now();
+    initialize(*parents, mode);
+    cout<<"Initialized "<<population_size<<" individuals in "
+        <<chrono::duration<double>(chrono::steady_clock::now() - start).count()<<"s\n";
+    for(int iter=1;iter<=max_iter;iter++){
+        generation(*parents, *children, mode, iter);
+        swap(parents, children);
+        cout<<"Generation "<<iter<<": best "<<setprecision(8)<<best_cell.fitness<<", mean "<<gen_stats.mean
+            <<setprecision(4)<<", io wait "<<io_wait<<"s, busy "<<busy<<"s\n";
+    }
+    cout<<"All best fitness: "<<setprecision(8)<<best_cell.fitness<<endl;
+    cout<<"All best (x1, x2): "<<best_cell.x1<<", "<<best_cell.x2<<endl;
+    cout<<"All best iter: "<<best_iter<<endl;
+    cout<<"Evaluations: "<<n_evals<<", last generation in "<<parents->path<<endl;
+}
+
+// ./stream_ga.out [--size N] [--chunk N] [--iter N] [--dir DIR] [FUNC [min_bound max_bound]]
+//   FUNC: hw1, q1, 或以 x1, x2 為變數的運算式
+//   例如: ./stream_ga.out --size 100000000 --dir /data/ga hw1
+int main(int argc, char *argv[]){
+    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
+
+    long population_size = 10000000, chunk_size = 1 << 16;
+    int max_iter = 20;
+    string dir = ".";
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--size" && i + 1 < argc)
+            population_size = atol(argv[++i]);
+        else if(arg == "--chunk" && i + 1 < argc)
+            chunk_size = atol(argv[++i]);
+        else if(arg == "--iter" && i + 1 < argc)
+            max_iter = atoi(argv[++i]);
+        else if(arg == "--dir" && i + 1 < argc)
+            dir = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    string func = (args.size() > 0) ? args[0] : "hw1";
+    float min_bound=0, max_bound=1;
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+    float p_mutation=0.01, p_crossover=0.25;
+    string mode = "max";
+
+    StreamGA ga(max_iter, population_size, chunk_size, min_bound, max_bound, p_mutation, p_crossover, find_fitness(func, 2));
+    ga.run(dir, mode);
+    cout<<"\n Now mode: "<<mode<<endl;
+    cout<<"Out-of-core GA ("<<population_size<<" individuals, chunk "<<ga.chunk_size<<")\n";
+}
@@ -0,0 +1,221 @@
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+#include<cmath>
+#include<cfloat>
+#include<vector>
+#include<algorithm>
+#include<stdexcept>
+using namespace std;
+
+// 不保留每次實驗結果的統計: 固定記憶體, 可以合併其他 thread / process 的結果.
+//   mean / variance: Welford, 合併時用 Chan 的公式.
+//   min / max: 精確值.
+//   quantile: t-digest (merging 版本, k1 scale function), 大約 compression 個 centroid.
+// pack() / unpack() 轉成 double 陣列, 可以直接經由 pipe 或 socket 傳給其他 process.
+
+class TDigest{
+public:
+    double compression;
+    TDigest(double compression = 100);
+    void add(double x, double weight = 1);
+    void merge(const TDigest &other);
+    double quantile(double q);
+    double total_weight();
+    vector<double> means, weights;      // 排序好的 centroid.
+    double min = DBL_MAX, max = -DBL_MAX;
+    void compress();
+private:
+    vector<double> buf_means, buf_weights;  // 還沒合併的點.
+};
+
+TDigest::TDigest(double compression){
+    this->compression = compression;
+}
+
+double TDigest::total_weight(){
+    double total = 0;
+    for(double w: weights)
+        total += w;
+    for(double w: buf_weights)
+        total += w;
+    return total;
+}
+
+void TDigest::add(double x, double weight){
+    min = std::min(min, x);
+    max = std::max(max, x);
+    buf_means.push_back(x);
+    buf_weights.push_back(weight);
+    if(buf_means.size() >= 8 * compression)
+        compress();
+}
+
+void TDigest::merge(const TDigest &other){
+    for(int i=0;i<(int)other.means.size();i++)
+        add(other.means[i], other.weights[i]);
+    for(int i=0;i<(int)other.buf_means.size();i++)
+        add(other.buf_means[i], other.buf_weights[i]);
+    // add() 只看到 centroid 的 mean, 真正的極值要另外合併.
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+// 依 mean 排序後由左到右合併, 相鄰 centroid 的 k(q) 相差不超過 1:
+//   k(q) = compression / (2 pi) * asin(2q - 1), 兩端的 centroid 因此較小.
+void TDigest::compress(){
+    if(buf_means.empty())
+        return;
+    vector<pair<double, double>> points;
+    points.reserve(means.size() + buf_means.size());
+    for(int i=0;i<(int)means.size();i++)
+        points.push_back({means[i], weights[i]});
+    for(int i=0;i<(int)buf_means.size();i++)
+        points.push_back({buf_means[i], buf_weights[i]});
+    buf_means.clear();
+    buf_weights.clear();
+    sort(points.begin(), points.end());
+
+    double total = 0;
+    for(auto &p: points)
+        total += p.second;
+    auto k = [this](double q){ return compression / (2 * M_PI) * asin(2 * q - 1); };
+
+    means.clear();
+    weights.clear();
+    double done = 0;    // 已經關閉的 centroid 的總權重.
+    double cur_mean = points[0].first, cur_weight = points[0].second;
+    double k_left = k(0);
+    for(int i=1;i<(int)points.size();i++){
+        double q = (done + cur_weight + points[i].second) / total;
+        if(k(q) - k_left <= 1){
+            cur_weight += points[i].second;
+            cur_mean += (points[i].first - cur_mean) * points[i].second / cur_weight;
+            continue;
+        }
+        means.push_back(cur_mean);
+        weights.push_back(cur_weight);
+        done += cur_weight;
+        k_left = k(done / total);
+        cur_mean = points[i].first;
+        cur_weight = points[i].second;
+    }
+    means.push_back(cur_mean);
+    weights.push_back(cur_weight);
+}
+
+// centroid 之間線性內插, centroid 的權重視為平均分布在中心兩側;
+// 兩端在 min / max 與第一個 / 最後一個 centroid 之間內插.
+double TDigest::quantile(double q){
+    compress();
+    if(means.empty())
+        return NAN;
+    double total = total_weight(), target = q * total, cum = 0;
+    for(int i=0;i<(int)means.size();i++){
+        double center = cum + weights[i] / 2;
+        if(target < center){
+            if(i == 0)
+                return min + (means[0] - min) * target / center;
+            double prev_center = cum - weights[i - 1] / 2;
+            double t = (target - prev_center) / (center - prev_center);
+            return means[i - 1] + t * (means[i] - means[i - 1]);
+        }
+        cum += weights[i];
+    }
+    double last_center = total - weights.back() / 2;
+    return means.back() + (max - means.back()) * (target - last_center) / (total - last_center);
+}
+
+class StreamStats{
+public:
+    long n = 0;
+    double mean = 0, m2 = 0;    // m2: 與 mean 差的平方和.
+    double min = DBL_MAX, max = -DBL_MAX;
+    TDigest digest;
+    void add(double x);
+    void merge(const StreamStats &other);
+    double variance();
+    double stddev();
+    double ci95();              // mean 的 95% 信賴區間半寬.
+    double quantile(double q);
+    vector<double> pack();
+    static StreamStats unpack(const double *data, size_t len);
+};
+
+void StreamStats::add(double x){
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+    digest.add(x);
+}
+
+void StreamStats::merge(const StreamStats &other){
+    if(other.n == 0)
+        return;
+    long total = n + other.n;
+    double delta = other.mean - mean;
+    mean += delta * other.n / total;
+    m2 += other.m2 + delta * delta * n * other.n / total;
+    n = total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    digest.merge(other.digest);
+}
+
+double StreamStats::variance(){
+    return (n > 1) ? m2 / (n - 1) : 0;
+}
+
+double StreamStats::stddev(){
+    return sqrt(variance());
+}
+
+// Student t 的 0.975 分位數, 自由度 30 以上用常態近似.
+double StreamStats::ci95(){
+    static const double t975[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045};
+    if(n < 2)
+        return NAN;
+    long df = n - 1;
+    double t = (df < 30) ? t975[df] : 1.96 + 2.5 / df;
+    return t * stddev() / sqrt((double)n);
+}
+
+double StreamStats::quantile(double q){
+    return digest.quantile(q);
+}
+
+// [n, mean, m2, min, max, compression, centroid 數, (mean, weight) ...]
+vector<double> StreamStats::pack(){
+    digest.compress();
+    vector<double> data = {(double)n, mean, m2, min, max, digest.compression, (double)digest.means.size()};
+    for(int i=0;i<(int)digest.means.size();i++){
+        data.push_back(digest.means[i]);
+        data.push_back(digest.weights[i]);
+    }
+    return data;
+}
+
+StreamStats StreamStats::unpack(const double *data, size_t len){
+    if(len < 7 || len != 7 + 2 * (size_t)data[6])
+        throw runtime_error("bad packed StreamStats");
+    StreamStats stats;
+    stats.n = data[0];
+    stats.mean = data[1];
+    stats.m2 = data[2];
+    stats.min = data[3];
+    stats.max = data[4];
+    stats.digest = TDigest(data[5]);
+    stats.digest.min = stats.min;
+    stats.digest.max = stats.max;
+    for(size_t i=7;i<len;i+=2){
+        stats.digest.means.push_back(data[i]);
+        stats.digest.weights.push_back(data[i + 1]);
+    }
+    return stats;
+}
+
+#endif
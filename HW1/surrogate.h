@@ -0,0 +1,151 @@
+#ifndef SURROGATE_H
+#define SURROGATE_H
+#include<cmath>
+#include<vector>
+#include<algorithm>
+using namespace std;
+
+// k-nearest-neighbor 回歸的 surrogate model, 用已經真正算過的
+// (x1, x2, fitness) 預測新個體的 fitness.
+// 樣本放在 [min_bound, max_bound]^2 的均勻 grid 裡, 新增為 O(1),
+// 查詢只需由近到遠掃描附近的格子. 每格平均樣本太多時 grid 加倍;
+// 每格最多 BUCKET_CAP 個樣本, 滿了就覆蓋該格最舊的樣本, 收斂後查詢成本仍固定.
+class KnnSurrogate{
+public:
+    static constexpr int BUCKET_CAP = 32;
+    int k;
+    float min_bound, max_bound;
+    vector<double> xs, ys, fs;
+    KnnSurrogate(int k, float min_bound, float max_bound);
+    void add(double x1, double x2, double fitness);
+    double predict(double x1, double x2);
+    int size();
+private:
+    int grid_n;
+    double cell_width;
+    vector<vector<int>> buckets;
+    vector<int> oldest;     // 每格下一個要覆蓋的位置.
+    int bucket_of(double v);
+    void rebuild(int new_grid_n);
+};
+
+KnnSurrogate::KnnSurrogate(int k, float min_bound, float max_bound){
+    this->k = k;
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    rebuild(16);
+}
+
+int KnnSurrogate::size(){
+    return fs.size();
+}
+
+int KnnSurrogate::bucket_of(double v){
+    int b = (v - min_bound) / cell_width;
+    return min(max(b, 0), grid_n - 1);
+}
+
+// 重新分格後只留下每格最新的 BUCKET_CAP 個樣本, 並把 xs / ys / fs 壓縮成只有這些樣本,
+// 所以 size() 與查詢看到的樣本一致, 記憶體也不會超過每格的上限.
+void KnnSurrogate::rebuild(int new_grid_n){
+    // 每格從 oldest 開始繞一圈就是由舊到新的順序.
+    vector<int> order;
+    order.reserve(fs.size());
+    for(size_t b=0;b<buckets.size();b++){
+        int m = buckets[b].size();
+        for(int j=0;j<m;j++)
+            order.push_back(buckets[b][(oldest[b] + j) % m]);
+    }
+
+    grid_n = new_grid_n;
+    cell_width = (max_bound - min_bound) / grid_n;
+    buckets.assign((size_t)grid_n * grid_n, vector<int>());
+    oldest.assign((size_t)grid_n * grid_n, 0);
+    for(int i: order)
+        buckets[(size_t)bucket_of(ys[i]) * grid_n + bucket_of(xs[i])].push_back(i);
+
+    vector<double> new_xs, new_ys, new_fs;
+    for(vector<int> &bucket: buckets){
+        if((int)bucket.size() > BUCKET_CAP)
+            bucket.erase(bucket.begin(), bucket.end() - BUCKET_CAP);
+        for(int &i: bucket){
+            new_xs.push_back(xs[i]);
+            new_ys.push_back(ys[i]);
+            new_fs.push_back(fs[i]);
+            i = new_fs.size() - 1;
+        }
+    }
+    xs.swap(new_xs);
+    ys.swap(new_ys);
+    fs.swap(new_fs);
+}
+
+void KnnSurrogate::add(double x1, double x2, double fitness){
+    size_t b = (size_t)bucket_of(x2) * grid_n + bucket_of(x1);
+    if((int)buckets[b].size() == BUCKET_CAP){
+        int i = buckets[b][oldest[b]];
+        oldest[b] = (oldest[b] + 1) % BUCKET_CAP;
+        xs[i] = x1;
+        ys[i] = x2;
+        fs[i] = fitness;
+        return;
+    }
+    xs.push_back(x1);
+    ys.push_back(x2);
+    fs.push_back(fitness);
+    buckets[b].push_back(fs.size() - 1);
+    if(fs.size() > (size_t)4 * grid_n * grid_n && grid_n < 1024)
+        rebuild(grid_n * 2);
+}
+
+// 以距離倒數加權 k 個最近樣本的 fitness.
+double KnnSurrogate::predict(double x1, double x2){
+    int n = min(k, size());
+    if(n == 0)
+        return 0;
+    // (距離平方, 樣本 index), 以 max-heap 保留最近的 n 個.
+    vector<pair<double, int>> near;
+    int bx = bucket_of(x1), by = bucket_of(x2);
+    for(int ring=0;ring<grid_n;ring++){
+        // ring 以外的樣本距離至少為 (ring - 1) 個格寬, 已經找齊就停止.
+        if((int)near.size() == n && ring > 1){
+            double reach = (ring - 1) * cell_width;
+            if(near.front().first <= reach * reach)
+                break;
+        }
+        for(int gy=by-ring;gy<=by+ring;gy++){
+            if(gy < 0 || gy >= grid_n)
+                continue;
+            for(int gx=bx-ring;gx<=bx+ring;gx++){
+                if(gx < 0 || gx >= grid_n)
+                    continue;
+                if(max(abs(gx - bx), abs(gy - by)) != ring)
+                    continue;
+                for(int i: buckets[(size_t)gy * grid_n + gx]){
+                    double d = (xs[i] - x1) * (xs[i] - x1) + (ys[i] - x2) * (ys[i] - x2);
+                    if((int)near.size() < n){
+                        near.push_back({d, i});
+                        push_heap(near.begin(), near.end());
+                    }
+                    else if(d < near.front().first){
+                        pop_heap(near.begin(), near.end());
+                        near.back() = {d, i};
+                        push_heap(near.begin(), near.end());
+                    }
+                }
+            }
+        }
+    }
+
+    double weight_sum = 0, value = 0;
+    for(auto &p: near){
+        if(p.first < 1e-18)
+            return fs[p.second];
+        double w = 1.0 / sqrt(p.first);
+        weight_sum += w;
+        value += w * fs[p.second];
+    }
+    return value / weight_sum;
+}
+
+#endif
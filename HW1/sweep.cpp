@@ -0,0 +1,271 @@
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<cstdio>
+#include<cstring>
+#include<cstdint>
+#include<string>
+#include<vector>
+#include<map>
+#include<chrono>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/wait.h>
+#define GA_NO_MAIN
+#include"ga_float.cpp"
+using namespace std;
+
+// 參數掃描: 從設定檔讀入參數的 grid, 把 (參數組合 × seed) 的 job 分給多個 process,
+// 並用 racing 提早淘汰明顯較差的組合. 每個 job 是一個 fork 出來的 process,
+// rand() 與 GAFloat 的輸出互不干擾, 結果經由 pipe 傳回.
+//
+// 設定檔 (例如 sweep.cfg), 每行 "名稱 = 值, 值, ...", # 之後為註解:
+//   grid 參數 (可以有多個值, 所有組合都會跑):
+//     max_iter, population_size, precision, p_mutation, p_crossover, times, elite_size
+//   其他設定 (單一值):
+//     expression, min_bound, max_bound, mode, seeds (最多幾輪), min_rounds, processes
+//
+// Racing: 第 r 輪讓所有還沒被淘汰的組合各跑 seed r (同一輪的組合用相同的 seed).
+// 跑完 min_rounds 輪後, 若某組合 mean 的 95% 信賴區間整個比目前最好的組合差, 就淘汰它.
+//
+// 輸出為 columnar 檔案: SWEEP_HEADER bytes 的文字 header, 之後每個 column 連續存放 rows 個 float64.
+//   header: "GASWEEP1\nrows N\ncolumns name1 name2 ...\n", 其餘補 '\0'.
+
+const int SWEEP_HEADER = 1024;
+const vector<string> GRID_KEYS = {"max_iter", "population_size", "precision", "p_mutation", "p_crossover", "times", "elite_size"};
+
+struct SweepConfig{
+    map<string, vector<double>> grid;
+    string expression, mode = "max";
+    float min_bound = 0, max_bound = 1;
+    int seeds = 10, min_rounds = 5, processes = default_threads();
+};
+
+struct JobResult{
+    double fitness, best_iter, x1, x2, seconds;
+};
+
+string trim(string s){
+    size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+    return (b == string::npos) ? "" : s.substr(b, e - b + 1);
+}
+
+SweepConfig read_config(string path){
+    SweepConfig cfg;
+    cfg.grid = {{"max_iter", {10000}}, {"population_size", {100}}, {"precision", {0.0001}},
+                {"p_mutation", {0.01}}, {"p_crossover", {0.25}}, {"times", {5}}, {"elite_size", {2}}};
+    ifstream in(path);
+    if(!in)
+        throw runtime_error("cannot read " + path);
+    string line;
+    for(int line_no=1;getline(in, line);line_no++){
+        line = trim(line.substr(0, line.find('#')));
+        if(line.empty())
+            continue;
+        size_t eq = line.find('=');
+        if(eq == string::npos)
+            throw runtime_error(path + ":" + to_string(line_no) + ": expected name = value");
+        string key = trim(line.substr(0, eq)), value = trim(line.substr(eq + 1));
+        if(key == "expression")
+            cfg.expression = value;
+        else if(key == "mode")
+            cfg.mode = value;
+        else if(key == "min_bound")
+            cfg.min_bound = atof(value.c_str());
+        else if(key == "max_bound")
+            cfg.max_bound = atof(value.c_str());
+        else if(key == "seeds")
+            cfg.seeds = atoi(value.c_str());
+        else if(key == "min_rounds")
+            cfg.min_rounds = atoi(value.c_str());
+        else if(key == "processes")
+            cfg.processes = atoi(value.c_str());
+        else if(cfg.grid.count(key)){
+            vector<double> values;
+            stringstream ss(value);
+            string item;
+            while(getline(ss, item, ','))
+                values.push_back(atof(item.c_str()));
+            if(values.empty())
+                throw runtime_error(path + ":" + to_string(line_no) + ": no values for " + key);
+            cfg.grid[key] = values;
+        }
+        else
+            throw runtime_error(path + ":" + to_string(line_no) + ": unknown parameter " + key);
+    }
+    if(cfg.mode != "max" && cfg.mode != "min")
+        throw runtime_error("mode must be max or min");
+    if(!cfg.expression.empty())
+        ExprVM check(cfg.expression);   // 在 fork 之前先檢查語法.
+    return cfg;
+}
+
+// grid 的所有組合, 每個組合的值依 GRID_KEYS 的順序.
+vector<vector<double>> expand_grid(SweepConfig &cfg){
+    vector<vector<double>> configs = {{}};
+    for(string key: GRID_KEYS){
+        vector<vector<double>> next;
+        for(vector<double> &partial: configs)
+            for(double v: cfg.grid[key]){
+                next.push_back(partial);
+                next.back().push_back(v);
+            }
+        configs = next;
+    }
+    return configs;
+}
+
+// 在 child process 中執行一個 job.
+JobResult run_job(SweepConfig &cfg, vector<double> &params, int seed){
+    srand(seed + 1);    // glibc 的 srand(0) 與 srand(1) 相同, seed 由 0 開始所以加 1.
+    auto start = chrono::steady_clock::now();
+    GAFloat ga(params[0], params[1], cfg.min_bound, cfg.max_bound, params[2], params[3], params[4]);
+    ExprVM *fitness_expr = cfg.expression.empty() ? NULL : new ExprVM(cfg.expression);
+    ga.fitness_expr = fitness_expr;
+    ga.elite_size = params[6];
+    ga.run(cfg.mode, params[5]);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return {ga.best_cell.fitness, (double)ga.best_iter, ga.best_cell.x1, ga.best_cell.x2, seconds};
+}
+
+// 同時最多 processes 個 child, 每個 child 跑一個 job 後把 JobResult 寫進 pipe.
+void run_round(SweepConfig &cfg, vector<vector<double>> &configs, vector<int> &alive, int seed,
+               vector<JobResult> &results){
+    map<pid_t, pair<int, int>> running;     // pid -> (job index, pipe fd)
+    int next = 0, done = 0, n = alive.size();
+    results.assign(n, JobResult());
+    cout.flush();
+    while(done < n){
+        while(next < n && (int)running.size() < cfg.processes){
+            int fds[2];
+            if(pipe(fds) < 0)
+                throw runtime_error("pipe failed");
+            pid_t pid = fork();
+            if(pid == 0){
+                close(fds[0]);
+                int null_fd = open("/dev/null", O_WRONLY);
+                dup2(null_fd, STDOUT_FILENO);
+                JobResult result = run_job(cfg, configs[alive[next]], seed);
+                write_full(fds[1], &result, sizeof(result));
+                _exit(0);
+            }
+            close(fds[1]);
+            running[pid] = {next++, fds[0]};
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if(pid < 0 || !running.count(pid))
+            continue;
+        auto job = running[pid];
+        running.erase(pid);
+        if(!read_full(job.second, &results[job.first], sizeof(JobResult)))
+            throw runtime_error("job " + to_string(alive[job.first]) + " failed");
+        close(job.second);
+        done++;
+    }
+}
+
+void write_columns(string path, vector<string> &names, vector<vector<double>> &columns){
+    string head = "GASWEEP1\nrows " + to_string(columns[0].size()) + "\ncolumns";
+    for(string name: names)
+        head += " " + name;
+    head += "\n";
+    if((int)head.size() > SWEEP_HEADER)
+        throw runtime_error("too many columns");
+    head.resize(SWEEP_HEADER, '\0');
+    FILE *fp = fopen(path.c_str(), "wb");
+    if(fp == NULL)
+        throw runtime_error("cannot write " + path);
+    fwrite(head.data(), 1, head.size(), fp);
+    for(vector<double> &col: columns)
+        fwrite(col.data(), sizeof(double), col.size(), fp);
+    fclose(fp);
+}
+
+// ./sweep.out CONFIG OUT.cols
+int main(int argc, char *argv[]){
+    if(argc < 3){
+        cout<<"usage: "<<argv[0]<<" CONFIG OUT.cols\n";
+        return 1;
+    }
+    SweepConfig cfg = read_config(argv[1]);
+    vector<vector<double>> configs = expand_grid(cfg);
+    int n_configs = configs.size();
+    cout<<n_configs<<" configurations, up to "<<cfg.seeds<<" seeds, "<<cfg.processes<<" processes\n";
+
+    auto better = [&cfg](double a, double b){ return (cfg.mode == "max") ? a > b : a < b; };
+    vector<StreamStats> stats(n_configs);
+    vector<int> alive(n_configs), dropped_at(n_configs, -1);
+    for(int c=0;c<n_configs;c++)
+        alive[c] = c;
+
+    vector<string> names = {"config", "seed"};
+    names.insert(names.end(), GRID_KEYS.begin(), GRID_KEYS.end());
+    for(string name: {"fitness", "best_iter", "x1", "x2", "seconds"})
+        names.push_back(name);
+    vector<vector<double>> columns(names.size());
+
+    auto start = chrono::steady_clock::now();
+    int n_jobs = 0;
+    for(int seed=0;seed<cfg.seeds && (alive.size() > 1 || seed < cfg.min_rounds);seed++){
+        vector<JobResult> results;
+        run_round(cfg, configs, alive, seed, results);
+        for(int k=0;k<(int)alive.size();k++){
+            int c = alive[k];
+            JobResult &r = results[k];
+            stats[c].add(r.fitness);
+            vector<double> row = {(double)c, (double)seed};
+            row.insert(row.end(), configs[c].begin(), configs[c].end());
+            for(double v: {r.fitness, r.best_iter, r.x1, r.x2, r.seconds})
+                row.push_back(v);
+            for(int j=0;j<(int)row.size();j++)
+                columns[j].push_back(row[j]);
+        }
+        n_jobs += alive.size();
+
+        // Racing.
+        if(seed + 1 < cfg.min_rounds)
+            continue;
+        int best = alive[0];
+        for(int c: alive)
+            if(better(stats[c].mean, stats[best].mean))
+                best = c;
+        double best_bound = (cfg.mode == "max") ? stats[best].mean - stats[best].ci95() : stats[best].mean + stats[best].ci95();
+        vector<int> survivors;
+        for(int c: alive){
+            double bound = (cfg.mode == "max") ? stats[c].mean + stats[c].ci95() : stats[c].mean - stats[c].ci95();
+            if(c != best && better(best_bound, bound))
+                dropped_at[c] = seed + 1;
+            else
+                survivors.push_back(c);
+        }
+        if(survivors.size() < alive.size())
+            cout<<"Round "<<seed + 1<<": dropped "<<alive.size() - survivors.size()<<", "<<survivors.size()<<" left\n";
+        alive = survivors;
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    write_columns(argv[2], names, columns);
+
+    // 依 mean 排序列出結果.
+    vector<int> order(n_configs);
+    for(int c=0;c<n_configs;c++)
+        order[c] = c;
+    sort(order.begin(), order.end(), [&](int a, int b){ return better(stats[a].mean, stats[b].mean); });
+    cout<<"|config|";
+    for(string key: GRID_KEYS)
+        cout<<key<<"|";
+    cout<<"runs|fitness mean|95% CI|dropped at|\n|-|";
+    for(int i=0;i<(int)GRID_KEYS.size();i++)
+        cout<<"-|";
+    cout<<"-|-|-|-|\n";
+    for(int c: order){
+        cout<<"|"<<c<<"|";
+        for(double v: configs[c])
+            cout<<v<<"|";
+        cout<<stats[c].n<<"|"<<setprecision(6)<<stats[c].mean<<"|"<<setprecision(4)<<stats[c].ci95()<<"|";
+        if(dropped_at[c] > 0)
+            cout<<dropped_at[c];
+        cout<<"|\n";
+    }
+    cout<<n_jobs<<" jobs ("<<n_configs * cfg.seeds<<" without racing) in "<<elapsed<<"s -> "<<argv[2]<<"\n";
+}
@@ -0,0 +1,291 @@
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<vector>
+#include<deque>
+#include<unordered_map>
+#include<climits>
+#include"ga_util.h"
+#include"expr_vm.h"
+#include"anytime.h"
+#include"low_discrepancy.h"
+using namespace std;
+
+struct cell{
+    double x1, x2;
+    double fitness;
+};
+
+// 與 HillClimbing 相同的 move() 鄰域, 但每一步都移到最好的非 tabu 鄰居, 即使比較差,
+// 所以不需要重新開始就能離開 local optimum.
+// sin(50 r^0.1) 的山脊是一整圈, 只在 precision 附近移動會沿著山脊一直走, 所以連續 stall 步
+// 沒有改善時把 move() 的範圍 radius 加倍 (最多整個範圍的 1/4), 改善後再回到 precision.
+// Tabu memory: 位置以格子量化, 格子寬度跟著 radius 變大 (第 level 層為 grid_size * 2^level),
+// 所以鄰域放大後, 最近離開的整個山谷仍然是 tabu. 每一步把位置在每一層的格子都放進 hash set,
+// 查詢時只看目前 level 的格子, 是 O(1); deque 記錄加入的順序, 超過 tenure 步的格子移出.
+// Aspiration: tabu 的鄰居若比目前為止最好的 node 還好, 仍然可以移過去.
+// 連續 patience 步沒有改善 best_node 就停止.
+class TabuSearch{
+public:
+    int max_iter, best_iter=0;
+    float min_bound, max_bound, precision;
+    float grid_size;            // 第 0 層 tabu 格子的寬度, 第 level 層為 grid_size * 2^level.
+    int tenure = 50;            // 格子保持 tabu 的步數.
+    int patience = 300;
+    int stall = 20;             // 連續 stall 步沒有改善就把鄰域放大一倍.
+    float radius;               // 目前 move() 的範圍, 改善 best_node 時回到 precision.
+    int level, max_level;       // radius = precision * 2^level (最後一層被範圍的 1/4 截斷).
+    long n_evals = 0, n_aspirations = 0;
+    cell cur_node, best_node;   // 目前的 node, 記錄下分數最好的 node
+    vector<cell> best_node_list;    // 記錄每一個 iteration 裡面最佳的 cell.
+    vector<cell> next_nodes;
+    unordered_map<long long, int> tabu;    // 格子 -> 在 tabu_order 中出現的次數.
+    deque<long long> tabu_order;
+    ExprVM *fitness_expr = NULL;    // 不為 NULL 時以運算式取代內建的 fitness.
+    AnytimeTrace *trace = NULL;     // 不為 NULL 時記錄每次 evaluation 後的 best-so-far.
+    Sampler *init_sampler = NULL;   // 不為 NULL 時 initialize() 取序列的下一個點.
+    TabuSearch(int max_iter, float min_bound, float max_bound, float precision);
+    void initialize();
+    void evaluate(cell &node);
+    void move();
+    cell run(string mode);
+    void find_best(string mode);
+    long long grid_key(const cell &node, int level);
+    void make_tabu(const cell &node);
+    void print_info(int iter_interval);
+    double randfloat(float min, float max);
+    void check_bound(cell &node);
+};
+
+TabuSearch::TabuSearch(int max_iter, float min_bound, float max_bound, float precision){
+    this->max_iter = max_iter;
+    this->min_bound = min_bound;
+    this->max_bound = max_bound;
+    this->precision = precision;
+    this->grid_size = precision / 2;
+    this->radius = precision;
+}
+
+double TabuSearch::randfloat(float min, float max){
+    return (max - min) * rand() / RAND_MAX + min;
+}
+
+void TabuSearch::initialize(){
+    if(init_sampler != NULL){
+        double u[2];
+        init_sampler->next(1, u, min_bound, max_bound);
+        cur_node.x1 = u[0];
+        cur_node.x2 = u[1];
+        return;
+    }
+    cur_node.x1 = randfloat(min_bound, max_bound);
+    cur_node.x2 = randfloat(min_bound, max_bound);
+}
+
+void TabuSearch::evaluate(cell &node){
+    if(fitness_expr != NULL)
+        node.fitness = fitness_expr->eval(node.x1, node.x2);
+    else{
+        double x1 = node.x1, x2 = node.x2;
+        double left_part = pow(x1*x1 + x2*x2, 0.25),
+                right_part = pow(sin(50*pow((x1*x1 + x2*x2), 0.1)), 2.0) + 1;
+
+        node.fitness = left_part * right_part;
+    }
+    n_evals++;
+    if(trace != NULL)
+        trace->record(node.fitness);
+}
+
+void TabuSearch::check_bound(cell &node){
+    if(node.x1 < min_bound) node.x1 = min_bound;
+    if(node.x1 > max_bound) node.x1 = max_bound;
+    if(node.x2 < min_bound) node.x2 = min_bound;
+    if(node.x2 > max_bound) node.x2 = max_bound;
+}
+
+// level 佔最高的 4 bit, 兩個格子座標各佔 30 bit.
+long long TabuSearch::grid_key(const cell &node, int level){
+    double width = ldexp(grid_size, level);
+    long long g1 = floor((node.x1 - min_bound) / width),
+              g2 = floor((node.x2 - min_bound) / width);
+    return ((long long)level << 60) ^ ((g1 & 0x3FFFFFFFLL) << 30) ^ (g2 & 0x3FFFFFFFLL);
+}
+
+// tabu_order 每一步固定放 max_level + 1 個 key, 所以移出的正好是 tenure 步之前的;
+// 同一個格子可能被放進好幾次, 次數歸零時才不再是 tabu.
+void TabuSearch::make_tabu(const cell &node){
+    for(int l=0;l<=max_level;l++){
+        long long key = grid_key(node, l);
+        tabu[key]++;
+        tabu_order.push_back(key);
+    }
+    while((int)tabu_order.size() > tenure * (max_level + 1)){
+        auto it = tabu.find(tabu_order.front());
+        if(--it->second == 0)
+            tabu.erase(it);
+        tabu_order.pop_front();
+    }
+}
+
+cell TabuSearch::run(string mode){
+    tabu.clear();
+    tabu_order.clear();
+    max_level = 0;
+    for(float r=precision;r<(max_bound - min_bound) / 4;r*=2)
+        max_level++;
+    tabu.reserve(2 * tenure * (max_level + 1));
+    initialize();
+    evaluate(cur_node);
+    best_node = cur_node;
+    best_iter = 0;
+    radius = precision;
+    level = 0;
+    make_tabu(cur_node);
+    for(int iter=0;iter<max_iter && iter - best_iter < patience;iter++){
+        // Move the posoition of node.
+        move();
+        find_best(mode);
+        make_tabu(cur_node);
+        best_node_list.push_back(cur_node);
+
+        if((mode == "max" && cur_node.fitness > best_node.fitness) ||
+           (mode == "min" && cur_node.fitness < best_node.fitness)){
+            best_node = cur_node;
+            best_iter = iter+1;
+            radius = precision;
+            level = 0;
+        }
+        else if((iter + 1 - best_iter) % stall == 0 && level < max_level){
+            radius = min(2 * radius, (max_bound - min_bound) / 4);
+            level++;
+        }
+    }
+    return best_node;
+}
+
+void TabuSearch::move(){
+    next_nodes.clear();
+    for(int i=0;i<30;i++){
+        cell node;
+        node.x1 = cur_node.x1 + randfloat(-1*radius, radius);
+        node.x2 = cur_node.x2 + randfloat(-1*radius, radius);
+        check_bound(node);
+        evaluate(node);
+        next_nodes.push_back(node);
+    }
+}
+
+// 移到最好的非 tabu 鄰居, 或比 best_node 還好的 tabu 鄰居 (aspiration).
+// 所有鄰居都是 tabu 時 (格子比 precision 大, 或被邊界夾住) 移到最好的鄰居.
+void TabuSearch::find_best(string mode){
+    int idx = -1;
+    bool aspired = false;
+    for(int i=0;i<(int)next_nodes.size();i++){
+        double f = next_nodes[i].fitness;
+        if(idx >= 0 && ((mode == "max") ? f <= next_nodes[idx].fitness : f >= next_nodes[idx].fitness))
+            continue;
+        bool better_than_best = (mode == "max") ? f > best_node.fitness : f < best_node.fitness;
+        bool is_tabu = tabu.count(grid_key(next_nodes[i], level)) > 0;
+        if(is_tabu && !better_than_best)
+            continue;
+        idx = i;
+        aspired = is_tabu;
+    }
+    if(idx < 0){
+        idx = 0;
+        for(int i=1;i<(int)next_nodes.size();i++)
+            if((mode == "max") ? next_nodes[i].fitness > next_nodes[idx].fitness : next_nodes[i].fitness < next_nodes[idx].fitness)
+                idx = i;
+    }
+    n_aspirations += aspired;
+    cur_node = next_nodes[idx];
+}
+
+void TabuSearch::print_info(int iter_interval){
+    for(int iter=0;iter<(int)best_node_list.size();iter+=iter_interval){
+        cell node = best_node_list[iter];
+        cout<<"Iteration: "<<iter<<"\n"
+            <<"best fitness: "<<node.fitness<<"\n"
+            <<"(x1, x2) = ("<<node.x1<<", "<<node.x2<<")\n";
+
+        cout<<"======\n";
+    }
+
+    cout<<"All best fitness: "<<best_node.fitness<<endl;
+    cout<<"All best (x1, x2): "<<best_node.x1<<", "<<best_node.x2<<endl;
+    cout<<"All best iter: "<<best_iter<<endl;
+}
+
+#ifndef GA_NO_MAIN    // pyga.cpp 等其他程式 include 這個檔案時不需要 main.
+// ./tabu_search.out [--sampler sobol|halton] ["fitness expression" [min_bound max_bound]]
+// --sampler: 每次實驗的起點依序取自同一個序列.
+int main(int argc, char *argv[]){
+    srand((unsigned)time(NULL));  // (unsigned)time(NULL)
+
+    int max_iter=5000;
+    float min_bound=0, max_bound=1;
+    float precision=0.01;
+
+    string sampler_kind;
+    vector<string> args;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg == "--sampler" && i + 1 < argc)
+            sampler_kind = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    ExprVM *fitness_expr = NULL;
+    if(args.size() > 0)
+        fitness_expr = new ExprVM(args[0]);
+    if(args.size() > 2){
+        min_bound = atof(args[1].c_str());
+        max_bound = atof(args[2].c_str());
+    }
+    Sampler *init_sampler = sampler_kind.empty() ? NULL : new Sampler(sampler_kind, 2, rand());
+
+    string mode = "max";
+    // 收集實驗數據用於計算平均和最大最小值範圍
+    StreamStats total_fitness, total_iter, total_x1, total_x2, total_evals;
+    // 收集數據之實驗次數
+    int exp_num=10;
+    for(int exp=0;exp<exp_num;exp++){
+        TabuSearch ts(
+            max_iter,
+            min_bound,
+            max_bound,
+            precision);
+        ts.fitness_expr = fitness_expr;
+        ts.init_sampler = init_sampler;
+
+        cell best_one = ts.run(mode);
+        total_fitness.add(best_one.fitness);
+        total_x1.add(best_one.x1);
+        total_x2.add(best_one.x2);
+        total_iter.add(ts.best_iter);
+        total_evals.add(ts.n_evals);
+    }
+
+    cout<<"===\n";
+    cout<<"|name|stats|\n";
+    cout<<"|-|-|\n";
+    cout<<"|fitness mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+    cout<<"|iter mean   | "<<total_iter.mean<<"|\n";
+    cout<<"|evals mean  | "<<total_evals.mean<<"|\n";
+    cout<<"|x1 mean     | "<<setprecision(4)<<total_x1.mean<<"|\n";
+    cout<<"|x2 mean     | "<<setprecision(4)<<total_x2.mean<<"|\n";
+
+    // 計算 range (min, max).
+    find_range(total_fitness, "fitness");
+    find_ci(total_fitness, "fitness");
+    find_range(total_iter, "iter");
+    find_range(total_evals, "evals");
+    find_range(total_x1, "x1");
+    find_range(total_x2, "x2");
+
+    cout<<"\nNow mode: "<<mode<<endl;
+    cout<<"Tabu search\n";
+}
+#endif
@@ -0,0 +1,249 @@
+#include<iostream>
+#include<cmath>
+#include<cstdlib>   // 亂數相關函數
+#include<ctime>     // 時間相關函數
+#include<vector>
+#include<climits>
+#include"../HW1/ga_util.h"
+using namespace std;
+
+// 圓錐的設計問題 (與 Q2.py 相同): 在體積 >= 200 的限制下, 使總面積最小.
+// fitness 為負的總面積, 以 "max" 模式求解.
+const double MIN_VOLUME = 200;
+
+double base_area(double r){
+    return -1 * M_PI * r * r;
+}
+
+double surface_area(double r, double h){
+    return -1 * M_PI * r * sqrt(r * r + h * h);
+}
+
+double total_area(double r, double h){
+    return base_area(r) + surface_area(r, h);
+}
+
+double volume(double r, double h){
+    return M_PI * r * r * h / 3;
+}
+
+struct cell{
+    double r, h;
+    double fitness;
+    double violation;   // 體積不足的量, 0 表示 feasible.
+};
+
+class ConstrainedGA{
+public:
+    int max_iter, population_size;
+    float r_min, r_max, h_min, h_max, p_mutation, p_crossover;
+    string constraint_mode;     // "repair", "penalty" 或 "feasibility".
+    double penalty = 10;        // penalty 模式中每單位違反量扣的分數.
+    vector<cell> population;
+    vector<cell> pool;
+    cell best_cell;
+    int best_iter, cur_iter=0;
+    ConstrainedGA(int max_iter, int population_size, float r_min, float r_max, float h_min, float h_max, float p_mutation, float p_crossover, string constraint_mode);
+    void initialize();
+    void repair(cell &node);
+    void evaluate();
+    bool better(const cell &a, const cell &b);
+    void crossover();
+    void mutation();
+    void select(int times);
+    void run(int times);
+    void find_best();
+    void print_info();
+    double randfloat(float min, float max);
+};
+
+ConstrainedGA::ConstrainedGA(int max_iter, int population_size, float r_min, float r_max, float h_min, float h_max, float p_mutation, float p_crossover, string constraint_mode){
+    this->max_iter = max_iter;
+    this->population_size = population_size;
+    this->r_min = r_min;
+    this->r_max = r_max;
+    this->h_min = h_min;
+    this->h_max = h_max;
+    this->p_mutation = p_mutation;
+    this->p_crossover = p_crossover;
+    this->constraint_mode = constraint_mode;
+}
+
+double ConstrainedGA::randfloat(float min, float max){
+    return (max - min) * rand() / RAND_MAX + min;
+}
+
+void ConstrainedGA::initialize(){
+    for(int i=0;i<population_size;i++){
+        cell node;
+        node.r = randfloat(r_min, r_max);
+        node.h = randfloat(h_min, h_max);
+        repair(node);
+        population.push_back(node);
+    }
+}
+
+// 一步把不 feasible 的個體投影回 volume = MIN_VOLUME 的邊界上:
+// 保留 r, 把 h 拉到剛好滿足體積; 若 h 超出上限, 改為 h = h_max 並求出對應的 r.
+// 取代 Q2.py check_volume 中重新抽樣直到滿足的迴圈.
+// 捨入誤差可能讓投影後的體積差一點點, 所以再往上調幾個 ulp 直到 volume >= MIN_VOLUME.
+void ConstrainedGA::repair(cell &node){
+    if(constraint_mode != "repair" || volume(node.r, node.h) >= MIN_VOLUME)
+        return;
+    double h_need = (node.r > 0) ? 3 * MIN_VOLUME / (M_PI * node.r * node.r) : INFINITY;
+    if(h_need <= h_max){
+        node.h = h_need;
+        while(volume(node.r, node.h) < MIN_VOLUME)
+            node.h = nextafter(node.h, INFINITY);
+    }
+    else{
+        node.h = h_max;
+        node.r = sqrt(3 * MIN_VOLUME / (M_PI * h_max));
+        while(volume(node.r, node.h) < MIN_VOLUME)
+            node.r = nextafter(node.r, INFINITY);
+    }
+}
+
+void ConstrainedGA::evaluate(){
+    for(auto& node: population){
+        node.violation = max(0.0, MIN_VOLUME - volume(node.r, node.h));
+        node.fitness = total_area(node.r, node.h);
+        if(constraint_mode == "penalty")
+            node.fitness -= penalty * node.violation;
+    }
+}
+
+// feasibility 模式使用 Deb 的規則: feasible 勝過 infeasible,
+// 都 infeasible 時違反量小的勝, 都 feasible 時比 fitness.
+bool ConstrainedGA::better(const cell &a, const cell &b){
+    if(constraint_mode == "feasibility" && (a.violation > 0 || b.violation > 0)){
+        if(a.violation == 0 || b.violation == 0)
+            return a.violation == 0;
+        return a.violation < b.violation;
+    }
+    return a.fitness > b.fitness;
+}
+
+void ConstrainedGA::select(int times){
+    pool.clear();
+    for(int i=0;i<population_size;i++){
+        int select_idx = rand() % population_size;
+        for(int j=0;j<times;j++){
+            int idx = rand() % population_size;
+            if(better(population[idx], population[select_idx]))
+                select_idx = idx;
+        }
+        pool.push_back(population[select_idx]);
+    }
+    population.clear();
+    population.assign(pool.begin(), pool.end());
+}
+
+void ConstrainedGA::crossover(){
+    int idx1, idx2;
+    for(int i=0;i<population_size;i++){
+        if((double)rand() / RAND_MAX > p_crossover)  // Do not corssover.
+            continue;
+        idx1 = rand() % population_size;
+        idx2 = rand() % population_size;
+        while(idx2 == idx1){
+            idx2 = rand() % population_size;
+        }
+
+        population[idx1].h = pool[idx2].h;
+        population[idx2].r = pool[idx1].r;
+        repair(population[idx1]);
+        repair(population[idx2]);
+    }
+}
+
+void ConstrainedGA::mutation(){
+    for(auto& node: population){
+        if((double)rand() / RAND_MAX < p_mutation)
+            node.r = randfloat(r_min, r_max);
+        if((double)rand() / RAND_MAX < p_mutation)
+            node.h = randfloat(h_min, h_max);
+        repair(node);
+    }
+}
+
+void ConstrainedGA::run(int times){
+    best_cell.fitness = INT_MIN;
+    best_iter = 0;
+    initialize();
+    evaluate();
+    for(int iter=0;iter<max_iter;iter++){
+        select(times);
+        crossover();
+        mutation();
+        evaluate();
+        find_best();
+    }
+}
+
+// 只有 feasible 的個體可以成為 best_cell, best_cell 記錄真正的總面積.
+void ConstrainedGA::find_best(){
+    cur_iter++;
+    for(auto& node: population){
+        if(node.violation > 0)
+            continue;
+        double area = total_area(node.r, node.h);
+        if(area > best_cell.fitness){
+            best_cell = node;
+            best_cell.fitness = area;
+            best_iter = cur_iter;
+        }
+    }
+}
+
+void ConstrainedGA::print_info(){
+    cout<<"All best fitness: "<<-best_cell.fitness<<endl;
+    cout<<"All best volume: "<<volume(best_cell.r, best_cell.h)<<endl;
+    cout<<"All best (r, h): "<<best_cell.r<<", "<<best_cell.h<<endl;
+    cout<<"All best iter: "<<best_iter<<endl;
+}
+
+int main(){
+    srand((unsigned)time(NULL));
+
+    int max_iter=5000, population_size=50;
+    float r_min=0, r_max=10, h_min=0, h_max=20;
+    float p_mutation=0.01, p_crossover=0.25;
+    int times = 5;
+
+    vector<string> modes = {"repair", "penalty", "feasibility"};
+    for(string constraint_mode: modes){
+        // 收集實驗數據用於計算平均和最大最小值範圍
+        StreamStats total_fitness, total_iter, total_r, total_h;
+        // 收集數據之實驗次數
+        int exp_num=10;
+        for(int exp=0;exp<exp_num;exp++){
+            ConstrainedGA ga(
+                max_iter,
+                population_size,
+                r_min, r_max,
+                h_min, h_max,
+                p_mutation,
+                p_crossover,
+                constraint_mode);
+            ga.run(times);
+
+            total_fitness.add(-ga.best_cell.fitness);
+            total_r.add(ga.best_cell.r);
+            total_h.add(ga.best_cell.h);
+            total_iter.add(ga.best_iter);
+        }
+
+        cout<<"\nConstraint mode: "<<constraint_mode<<"\n";
+        cout<<"|name|stats|\n";
+        cout<<"|-|-|\n";
+        cout<<"|Total area mean| "<<setprecision(6)<<total_fitness.mean<<"|\n";
+        cout<<"|iter mean      | "<<total_iter.mean<<"|\n";
+        cout<<"|r mean         | "<<setprecision(4)<<total_r.mean<<"|\n";
+        cout<<"|h mean         | "<<setprecision(4)<<total_h.mean<<"|\n";
+        find_range(total_fitness, "Total area");
+        find_ci(total_fitness, "Total area");
+        find_range(total_r, "r");
+        find_range(total_h, "h");
+    }
+}
@@ -11,6 +11,45 @@ def fitness_func(x, y):
  
 from mpl_toolkits.mplot3d import Axes3D  #用来给出三维坐标系。
 
+def load_landscape(path):
+    # 讀取 HW1/landscape.out 的輸出, 不複製資料.
+    # e.g. ../HW1/landscape.out q1 q1.raw -0.5:1.5:4096 -0.5:1.5:4096
+    import struct
+    with open(path, 'rb') as f:
+        head = f.read(256)
+    assert head[:7] == b'GALAND1'
+    header_size, ndim = struct.unpack_from('<II', head, 8)
+    shape = struct.unpack_from('<8Q', head, 16)[:ndim]
+    lo = struct.unpack_from('<8d', head, 80)[:ndim]
+    hi = struct.unpack_from('<8d', head, 144)[:ndim]
+    Z = np.memmap(path, dtype='<f8', mode='r', offset=header_size, shape=shape)
+    return Z, lo, hi
+
+def load_sweep(path):
+    # 讀取 HW1/sweep.out 的 columnar 輸出, 回傳 {column 名稱: array}.
+    # e.g. ../HW1/sweep.out ../HW1/sweep.cfg sweep.cols
+    with open(path, 'rb') as f:
+        head = f.read(1024).rstrip(b'\0').decode().split('\n')
+    assert head[0] == 'GASWEEP1'
+    rows = int(head[1].split()[1])
+    names = head[2].split()[1:]
+    data = np.memmap(path, dtype='<f8', mode='r', offset=1024, shape=(len(names), rows))
+    return {name: data[i] for i, name in enumerate(names)}
+
+def load_ecdf(path):
+    # 讀取 HW1/anytime.out 的輸出: checkpoints, targets, traces[solver][run][k], ecdf[solver][k].
+    # e.g. ../HW1/anytime.out --runs 25 --out anytime.ecdf
+    with open(path, 'rb') as f:
+        head = f.read(1024).rstrip(b'\0').decode().split('\n')
+        assert head[0] == 'GAECDF1'
+        solvers = head[1].split()[1:]
+        runs, K, T = (int(line.split()[1]) for line in head[2:5])
+        checkpoints = np.fromfile(f, dtype='<i8', count=K)
+        targets = np.fromfile(f, dtype='<f8', count=T)
+        traces = np.fromfile(f, dtype='<f4', count=len(solvers) * runs * K).reshape(len(solvers), runs, K)
+        ecdf = np.fromfile(f, dtype='<f4', count=len(solvers) * K).reshape(len(solvers), K)
+    return solvers, checkpoints, targets, traces, ecdf
+
 def draw_3D(X, Y, Z):
     figure = plt.figure()
 
@@ -1,6 +1,12 @@
 g++ Q1.cpp -o Q1.out
 ./Q1.out
 
+# g++ Q2.cpp -o Q2.out
+# ./Q2.out
+
+# g++ -O2 peaks.cpp -o peaks.out
+# ./peaks.out population.txt 0.25 5 4
+
 
 # g++ ga_float.cpp -o ga_float.out
 # ./ga_float.out
@@ -0,0 +1,57 @@
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<cstdlib>
+#include<chrono>
+#include<vector>
+#include<iomanip>
+#include"../HW1/peak_finder.h"
+using namespace std;
+
+// 找出 population 中的山峰 (取代 Q1.py 的 find_peak).
+// 輸入檔: 每行 "x y fitness" 的文字檔, 或副檔名為 .bin 的 float64 (x, y, fitness) 陣列.
+// ./peaks.out population.txt [eps=0.25] [min_pts=5] [k=4] [mode=max]
+int main(int argc, char *argv[]){
+    if(argc < 2){
+        cout<<"usage: "<<argv[0]<<" population.txt|.bin [eps] [min_pts] [k] [max|min]\n";
+        return 1;
+    }
+    string path = argv[1];
+    double eps = (argc > 2) ? atof(argv[2]) : 0.25;
+    int min_pts = (argc > 3) ? atoi(argv[3]) : 5;
+    int k = (argc > 4) ? atoi(argv[4]) : 4;
+    string mode = (argc > 5) ? argv[5] : "max";
+
+    vector<double> x1, x2, fitness;
+    if(path.size() > 4 && path.substr(path.size() - 4) == ".bin"){
+        ifstream fin(path, ios::binary);
+        double row[3];
+        while(fin.read((char*)row, sizeof(row))){
+            x1.push_back(row[0]);
+            x2.push_back(row[1]);
+            fitness.push_back(row[2]);
+        }
+    }
+    else{
+        ifstream fin(path);
+        double x, y, f;
+        while(fin>>x>>y>>f){
+            x1.push_back(x);
+            x2.push_back(y);
+            fitness.push_back(f);
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<Peak> peaks = find_peaks(x1, x2, fitness, eps, min_pts, mode);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout<<"Points: "<<fitness.size()<<", clusters: "<<peaks.size()<<", time: "<<elapsed<<"s\n";
+    for(int i=0;i<(int)peaks.size() && i<k;i++){
+        cout<<"Peak "<<i<<"\n";
+        cout<<"fitness = "<<peaks[i].fitness<<"\n";
+        cout<<"(x, y) = ("<<fixed<<setprecision(4)<<peaks[i].x1<<", "<<peaks[i].x2<<")\n";
+        cout<<"basin size = "<<peaks[i].basin_size<<"\n";
+        cout<<defaultfloat<<"----\n";
+    }
+}